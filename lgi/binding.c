@@ -0,0 +1,449 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native value transformations of property bindings.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+/* Retrieves numeric contents of the value, returns FALSE if the value
+   is not numeric. */
+gboolean
+lgi_value_number (const GValue *value, gdouble *number)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+#define H(gtype, get)				\
+      case gtype:				\
+	*number = get (value);			\
+	return TRUE;
+
+      H(G_TYPE_CHAR, g_value_get_schar)
+      H(G_TYPE_UCHAR, g_value_get_uchar)
+      H(G_TYPE_INT, g_value_get_int)
+      H(G_TYPE_UINT, g_value_get_uint)
+      H(G_TYPE_LONG, g_value_get_long)
+      H(G_TYPE_ULONG, g_value_get_ulong)
+      H(G_TYPE_INT64, g_value_get_int64)
+      H(G_TYPE_UINT64, g_value_get_uint64)
+      H(G_TYPE_FLOAT, g_value_get_float)
+      H(G_TYPE_DOUBLE, g_value_get_double)
+      H(G_TYPE_ENUM, g_value_get_enum)
+      H(G_TYPE_FLAGS, g_value_get_flags)
+#undef H
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Checks whether string key matches nick of the enum value, comparing
+   case-insensitively and treating '-' and '_' as equal. */
+gboolean
+lgi_enum_matches (const GValue *value, const gchar *key)
+{
+  GEnumClass *klass = g_type_class_ref (G_VALUE_TYPE (value));
+  GEnumValue *enum_value = g_enum_get_value (klass, g_value_get_enum (value));
+  gboolean matches = FALSE;
+  if (enum_value != NULL)
+    {
+      const gchar *nick = enum_value->value_nick;
+      for (; *key != '\0' && *nick != '\0'; key++, nick++)
+	if (g_ascii_tolower (*key) != g_ascii_tolower (*nick)
+	    && !((*key == '-' || *key == '_') && (*nick == '-' || *nick == '_')))
+	  break;
+      matches = *key == '\0' && *nick == '\0';
+    }
+  g_type_class_unref (klass);
+  return matches;
+}
+
+/* Validates format containing exactly one numeric conversion and
+   returns its copy, with integer conversions adjusted to take
+   gint64.  Returns NULL if the format is not valid. */
+gchar *
+lgi_format_parse (const char *format, gboolean *integer)
+{
+  const char *p, *conv = NULL;
+  for (p = format; *p != '\0'; p++)
+    if (*p == '%')
+      {
+	if (p[1] == '%')
+	  {
+	    p++;
+	    continue;
+	  }
+	if (conv != NULL)
+	  return NULL;
+	p++;
+	p += strspn (p, "-+ #0");
+	p += strspn (p, "0123456789");
+	if (*p == '.')
+	  {
+	    p++;
+	    p += strspn (p, "0123456789");
+	  }
+	if (*p == '\0' || strchr ("dioxXfFeEgG", *p) == NULL)
+	  return NULL;
+	conv = p;
+      }
+
+  if (conv == NULL)
+    return NULL;
+  *integer = strchr ("dioxX", *conv) != NULL;
+  if (!*integer)
+    return g_strdup (format);
+  return g_strdup_printf ("%.*s%s%s", (int) (conv - format), format,
+			  G_GINT64_MODIFIER, conv);
+}
+
+/* Kinds of native transformations. */
+typedef enum _TransformKind
+{
+  TRANSFORM_INVERT,
+  TRANSFORM_SCALE,
+  TRANSFORM_CLAMP,
+  TRANSFORM_MAP,
+  TRANSFORM_FORMAT,
+  TRANSFORM_THRESHOLD
+} TransformKind;
+
+static const char *const transform_kinds[] = {
+  "invert", "scale", "clamp", "map", "format", "threshold", NULL
+};
+
+/* Single mapping entry, mapping enum nick or number to string. */
+typedef struct _TransformMapEntry
+{
+  gchar *nick;
+  gdouble number;
+  gchar *string;
+} TransformMapEntry;
+
+/* Transformation attached to the binding. */
+typedef struct _Transform
+{
+  TransformKind kind;
+
+  /* Scale and offset, minimum and maximum, or threshold. */
+  gdouble a, b;
+
+  /* Format with single conversion. */
+  gchar *format;
+  gboolean format_integer;
+
+  /* Mapping table and string used for values not in the table. */
+  TransformMapEntry *entries;
+  gint n_entries;
+  gchar *fallback;
+} Transform;
+
+static void
+transform_free (gpointer data)
+{
+  Transform *transform = data;
+  gint i;
+  for (i = 0; i < transform->n_entries; i++)
+    {
+      g_free (transform->entries[i].nick);
+      g_free (transform->entries[i].string);
+    }
+  g_free (transform->entries);
+  g_free (transform->format);
+  g_free (transform->fallback);
+  g_free (transform);
+}
+
+/* Stores double or boolean result into target value. */
+static gboolean
+transform_set_number (GValue *target, gdouble number)
+{
+  GValue value = { 0 };
+  gboolean ok;
+  g_value_init (&value, G_TYPE_DOUBLE);
+  g_value_set_double (&value, number);
+  ok = g_value_transform (&value, target);
+  g_value_unset (&value);
+  return ok;
+}
+
+static gboolean
+transform_set_boolean (GValue *target, gboolean flag)
+{
+  GValue value = { 0 };
+  gboolean ok;
+  g_value_init (&value, G_TYPE_BOOLEAN);
+  g_value_set_boolean (&value, flag);
+  ok = g_value_transform (&value, target);
+  g_value_unset (&value);
+  return ok;
+}
+
+static gboolean
+transform_set_string (GValue *target, const gchar *string)
+{
+  if (!G_VALUE_HOLDS_STRING (target))
+    return FALSE;
+  g_value_set_string (target, string);
+  return TRUE;
+}
+
+static gboolean
+transform_get_number (const GValue *value, gdouble *number)
+{
+  if (G_VALUE_HOLDS_BOOLEAN (value))
+    {
+      *number = g_value_get_boolean (value);
+      return TRUE;
+    }
+  return lgi_value_number (value, number);
+}
+
+/* Transformation in the direction from source to target. */
+static gboolean
+transform_to (GBinding *binding, const GValue *from, GValue *to,
+	      gpointer user_data)
+{
+  Transform *transform = user_data;
+  gdouble number = 0;
+  gint i;
+  (void) binding;
+
+  switch (transform->kind)
+    {
+    case TRANSFORM_INVERT:
+      return transform_get_number (from, &number)
+	&& transform_set_boolean (to, number == 0);
+
+    case TRANSFORM_SCALE:
+      return transform_get_number (from, &number)
+	&& transform_set_number (to, number * transform->a + transform->b);
+
+    case TRANSFORM_CLAMP:
+      return transform_get_number (from, &number)
+	&& transform_set_number (to, CLAMP (number, transform->a,
+					    transform->b));
+
+    case TRANSFORM_THRESHOLD:
+      return transform_get_number (from, &number)
+	&& transform_set_boolean (to, number >= transform->a);
+
+    case TRANSFORM_FORMAT:
+      {
+	gchar *text;
+	gboolean ok;
+	if (!transform_get_number (from, &number))
+	  return FALSE;
+	text = transform->format_integer
+	  ? g_strdup_printf (transform->format, (gint64) number)
+	  : g_strdup_printf (transform->format, number);
+	ok = transform_set_string (to, text);
+	g_free (text);
+	return ok;
+      }
+
+    case TRANSFORM_MAP:
+      {
+	gboolean is_number = transform_get_number (from, &number);
+	gboolean is_enum = G_VALUE_HOLDS_ENUM (from);
+	for (i = 0; i < transform->n_entries; i++)
+	  {
+	    TransformMapEntry *entry = &transform->entries[i];
+	    if (entry->nick != NULL
+		? (is_enum && lgi_enum_matches (from, entry->nick))
+		: (is_number && entry->number == number))
+	      return transform_set_string (to, entry->string);
+	  }
+	return transform->fallback != NULL
+	  && transform_set_string (to, transform->fallback);
+      }
+    }
+
+  return FALSE;
+}
+
+/* Inverse transformation, from target back to source, available only
+   for invertible transformations. */
+static gboolean
+transform_from (GBinding *binding, const GValue *from, GValue *to,
+		gpointer user_data)
+{
+  Transform *transform = user_data;
+  gdouble number;
+  (void) binding;
+
+  if (!transform_get_number (from, &number))
+    return FALSE;
+  if (transform->kind == TRANSFORM_INVERT)
+    return transform_set_boolean (to, number == 0);
+  return transform_set_number (to, (number - transform->b) / transform->a);
+}
+
+/* Creates transformation from its definition table at narg:
+   { 'invert' }, { 'scale', factor[, offset] }, { 'clamp', min, max },
+   { 'map', { key = string, ... }[, default] }, { 'format', format }
+   or { 'threshold', value }. */
+static Transform *
+transform_new (lua_State *L, int narg)
+{
+  Transform *transform;
+  gpointer *guard;
+  lgi_makeabs (L, narg);
+  luaL_checktype (L, narg, LUA_TTABLE);
+
+  /* Keep transform guarded until it is attached to the binding. */
+  guard = lgi_guard_create (L, transform_free);
+  transform = *guard = g_new0 (Transform, 1);
+  lua_rawgeti (L, narg, 1);
+  transform->kind = luaL_checkoption (L, -1, NULL, transform_kinds);
+  lua_rawgeti (L, narg, 2);
+  lua_rawgeti (L, narg, 3);
+  switch (transform->kind)
+    {
+    case TRANSFORM_INVERT:
+      break;
+
+    case TRANSFORM_SCALE:
+      transform->a = luaL_checknumber (L, -2);
+      transform->b = luaL_optnumber (L, -1, 0);
+      if (transform->a == 0)
+	luaL_error (L, "scale transform: zero factor");
+      break;
+
+    case TRANSFORM_CLAMP:
+      transform->a = luaL_checknumber (L, -2);
+      transform->b = luaL_checknumber (L, -1);
+      break;
+
+    case TRANSFORM_THRESHOLD:
+      transform->a = luaL_checknumber (L, -2);
+      break;
+
+    case TRANSFORM_FORMAT:
+      transform->format = lgi_format_parse (luaL_checkstring (L, -2),
+					    &transform->format_integer);
+      if (transform->format == NULL)
+	luaL_error (L, "format transform: bad format '%s'",
+		    lua_tostring (L, -2));
+      break;
+
+    case TRANSFORM_MAP:
+      {
+	gint n = 0;
+	luaL_checktype (L, -2, LUA_TTABLE);
+	if (!lua_isnil (L, -1))
+	  transform->fallback = g_strdup (luaL_checkstring (L, -1));
+	for (lua_pushnil (L); lua_next (L, -3) != 0; lua_pop (L, 1))
+	  n++;
+	transform->entries = g_new0 (TransformMapEntry, n);
+	for (lua_pushnil (L); lua_next (L, -3) != 0; lua_pop (L, 1))
+	  {
+	    TransformMapEntry *entry =
+	      &transform->entries[transform->n_entries++];
+	    entry->string = g_strdup (luaL_checkstring (L, -1));
+	    if (lua_type (L, -2) == LUA_TNUMBER)
+	      entry->number = lua_tonumber (L, -2);
+	    else
+	      entry->nick = g_strdup (luaL_checkstring (L, -2));
+	  }
+	break;
+      }
+    }
+
+  lua_pop (L, 4);
+  *guard = NULL;
+  return transform;
+}
+
+/* Creates binding according to the definition of 6 values starting
+   at index narg: source, source_property, target, target_property,
+   flags and transformation table. */
+static GBinding *
+binding_create (lua_State *L, int narg)
+{
+  GObject *source, *target;
+  const gchar *source_property, *target_property;
+  GBindingFlags flags;
+  Transform *transform;
+
+  source = lgi_object_2c (L, narg, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  source_property = luaL_checkstring (L, narg + 1);
+  target = lgi_object_2c (L, narg + 2, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  target_property = luaL_checkstring (L, narg + 3);
+  flags = luaL_optinteger (L, narg + 4, 0);
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (source),
+				    source_property) == NULL)
+    luaL_error (L, "%s: no property `%s'", G_OBJECT_TYPE_NAME (source),
+		source_property);
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (target),
+				    target_property) == NULL)
+    luaL_error (L, "%s: no property `%s'", G_OBJECT_TYPE_NAME (target),
+		target_property);
+
+  transform = transform_new (L, narg + 5);
+  if ((flags & G_BINDING_BIDIRECTIONAL)
+      && transform->kind != TRANSFORM_INVERT
+      && transform->kind != TRANSFORM_SCALE)
+    {
+      const char *kind = transform_kinds[transform->kind];
+      transform_free (transform);
+      luaL_error (L, "transform `%s' cannot be bidirectional", kind);
+    }
+
+  return g_object_bind_property_full (source, source_property,
+				      target, target_property, flags,
+				      transform_to, transform_from,
+				      transform, transform_free);
+}
+
+/* binding = core.binding.new(source, source_property, target,
+				target_property, flags, transform) */
+static int
+binding_new (lua_State *L)
+{
+  lgi_object_2lua (L, binding_create (L, 1), FALSE, FALSE);
+  return 1;
+}
+
+/* bindings = core.binding.new_all { { source, source_property,
+     target, target_property, flags, transform }, ... } */
+static int
+binding_new_all (lua_State *L)
+{
+  int i, j, n;
+  luaL_checktype (L, 1, LUA_TTABLE);
+  n = lua_objlen (L, 1);
+  lua_createtable (L, n, 0);
+  for (i = 1; i <= n; i++)
+    {
+      GBinding *binding;
+      lua_rawgeti (L, 1, i);
+      luaL_checktype (L, -1, LUA_TTABLE);
+      luaL_checkstack (L, 6, "");
+      for (j = 1; j <= 6; j++)
+	lua_rawgeti (L, -j, j);
+      binding = binding_create (L, lua_gettop (L) - 5);
+      lua_pop (L, 7);
+      lgi_object_2lua (L, binding, FALSE, FALSE);
+      lua_rawseti (L, -2, i);
+    }
+  return 1;
+}
+
+static const luaL_Reg binding_reg[] = {
+  { "new", binding_new },
+  { "new_all", binding_new_all },
+  { NULL, NULL }
+};
+
+void
+lgi_binding_init (lua_State *L)
+{
+  lua_newtable (L);
+  luaL_register (L, NULL, binding_reg);
+  lua_setfield (L, -2, "binding");
+}
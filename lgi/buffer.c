@@ -5,7 +5,7 @@
  * Licensed under the MIT license:
  * http://www.opensource.org/licenses/mit-license.php
  *
- * Implementation of writable buffer object.
+ * Implementation of writable buffer object and read-only views.
  */
 
 #include <string.h>
@@ -84,8 +84,259 @@ buffer_new (lua_State *L)
   return 1;
 }
 
+/* Read-only view into memory owned by GBytes, which can be slice of
+   mapped file. */
+typedef struct _BytesView
+{
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size;
+} BytesView;
+
+static BytesView *
+view_push (lua_State *L, GBytes *bytes, const guint8 *data, gsize size)
+{
+  BytesView *view = lua_newuserdata (L, sizeof (BytesView));
+  view->bytes = bytes;
+  view->data = data;
+  view->size = size;
+  luaL_getmetatable (L, LGI_BYTES_VIEW);
+  lua_setmetatable (L, -2);
+  return view;
+}
+
+/* Converts Lua 1-based, possibly negative position to 0-based offset
+   like string.sub() does, clamped to 0..size. */
+static gsize
+view_offset (lua_Integer pos, gsize size)
+{
+  if (pos < 0)
+    pos += size + 1;
+  if (pos < 1)
+    return 0;
+  return ((gsize) pos > size) ? size : (gsize) pos - 1;
+}
+
+static int
+view_gc (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  g_bytes_unref (view->bytes);
+  return 0;
+}
+
+static int
+view_len (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_pushnumber (L, view->size);
+  return 1;
+}
+
+static int
+view_tostring (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_pushlstring (L, (const char *) view->data, view->size);
+  return 1;
+}
+
+static int
+view_index (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  if (lua_type (L, 2) == LUA_TNUMBER)
+    {
+      lua_Integer index = lua_tointeger (L, 2);
+      if (index > 0 && (gsize) index <= view->size)
+	lua_pushnumber (L, view->data[index - 1]);
+      else
+	lua_pushnil (L);
+    }
+  else
+    {
+      /* Look up the method. */
+      lua_pushvalue (L, 2);
+      lua_rawget (L, lua_upvalueindex (1));
+    }
+  return 1;
+}
+
+/* subview = view:sub(i[, j]) */
+static int
+view_sub (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_Integer size = view->size;
+  lua_Integer i = luaL_optinteger (L, 2, 1), j = luaL_optinteger (L, 3, -1);
+  if (i < 0)
+    i += size + 1;
+  if (i < 1)
+    i = 1;
+  else if (i > size + 1)
+    i = size + 1;
+  if (j < 0)
+    j += size + 1;
+  if (j > size)
+    j = size;
+  if (j < i)
+    j = i - 1;
+  view_push (L, g_bytes_ref (view->bytes), view->data + i - 1, j - i + 1);
+  return 1;
+}
+
+/* start, end = view:find(string[, init]), plain search only. */
+static int
+view_find (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  size_t len;
+  const char *needle = luaL_checklstring (L, 2, &len);
+  gsize pos = view_offset (luaL_optinteger (L, 3, 1), view->size);
+  const guint8 *found;
+
+  if (len == 0)
+    {
+      lua_pushnumber (L, pos + 1);
+      lua_pushnumber (L, pos);
+      return 2;
+    }
+  while (pos + len <= view->size)
+    {
+      found = memchr (view->data + pos, needle[0], view->size - pos - len + 1);
+      if (found == NULL)
+	break;
+      pos = found - view->data;
+      if (memcmp (found, needle, len) == 0)
+	{
+	  lua_pushnumber (L, pos + 1);
+	  lua_pushnumber (L, pos + len);
+	  return 2;
+	}
+      pos++;
+    }
+  lua_pushnil (L);
+  return 1;
+}
+
+/* value = view:read(kind, offset[, big_endian]), where offset is
+   1-based position of the first byte of the value. */
+static int
+view_read (lua_State *L)
+{
+  static const char *const kinds[] = {
+    "int8", "uint8", "int16", "uint16", "int32", "uint32",
+    "int64", "uint64", "float", "double", NULL
+  };
+  static const gsize sizes[] = { 1, 1, 2, 2, 4, 4, 8, 8, 4, 8 };
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  int kind = luaL_checkoption (L, 2, NULL, kinds);
+  lua_Integer offset = luaL_checkinteger (L, 3);
+  gboolean big_endian = lua_toboolean (L, 4);
+  union {
+    guint8 u8; guint16 u16; guint32 u32; guint64 u64;
+    gint8 i8; gint16 i16; gint32 i32; gint64 i64;
+    gfloat f; gdouble d;
+  } v;
+
+  luaL_argcheck (L, offset > 0
+		 && (gsize) offset - 1 + sizes[kind] <= view->size,
+		 3, "out of bounds");
+  memcpy (&v, view->data + offset - 1, sizes[kind]);
+  switch (sizes[kind])
+    {
+    case 2:
+      v.u16 = big_endian ? GUINT16_FROM_BE (v.u16) : GUINT16_FROM_LE (v.u16);
+      break;
+    case 4:
+      v.u32 = big_endian ? GUINT32_FROM_BE (v.u32) : GUINT32_FROM_LE (v.u32);
+      break;
+    case 8:
+      v.u64 = big_endian ? GUINT64_FROM_BE (v.u64) : GUINT64_FROM_LE (v.u64);
+      break;
+    }
+
+  switch (kind)
+    {
+    case 0: lua_pushnumber (L, v.i8); break;
+    case 1: lua_pushnumber (L, v.u8); break;
+    case 2: lua_pushnumber (L, v.i16); break;
+    case 3: lua_pushnumber (L, v.u16); break;
+    case 4: lua_pushnumber (L, v.i32); break;
+    case 5: lua_pushnumber (L, v.u32); break;
+    case 6: lua_pushnumber (L, (lua_Number) v.i64); break;
+    case 7: lua_pushnumber (L, (lua_Number) v.u64); break;
+    case 8: lua_pushnumber (L, v.f); break;
+    case 9: lua_pushnumber (L, v.d); break;
+    }
+  return 1;
+}
+
+/* GLib.Bytes sharing the memory of the view. */
+static int
+view_bytes (lua_State *L)
+{
+  BytesView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  const guint8 *base = g_bytes_get_data (view->bytes, NULL);
+  GBytes *bytes = g_bytes_new_from_bytes (view->bytes, view->data - base,
+					  view->size);
+  lgi_type_get_repotype (L, G_TYPE_BYTES, NULL);
+  lgi_record_2lua (L, bytes, TRUE, 0);
+  return 1;
+}
+
+static const luaL_Reg view_mt_reg[] = {
+  { "__gc", view_gc },
+  { "__len", view_len },
+  { "__tostring", view_tostring },
+  { NULL, NULL }
+};
+
+static const luaL_Reg view_methods_reg[] = {
+  { "sub", view_sub },
+  { "find", view_find },
+  { "read", view_read },
+  { "bytes", view_bytes },
+  { NULL, NULL }
+};
+
+/* view = bytes.view(source), where source is GLib.Bytes,
+   GLib.MappedFile or another view. */
+static int
+view_new (lua_State *L)
+{
+  GBytes *bytes = NULL;
+  GMappedFile *mapped = NULL;
+  gconstpointer data;
+  gsize size;
+
+  if (lgi_udata_test (L, 1, LGI_BYTES_VIEW))
+    {
+      lua_settop (L, 1);
+      return 1;
+    }
+
+  lgi_type_get_repotype (L, G_TYPE_BYTES, NULL);
+  lgi_record_2c (L, 1, &bytes, FALSE, FALSE, TRUE, TRUE);
+  if (bytes != NULL)
+    g_bytes_ref (bytes);
+  else
+    {
+      lgi_type_get_repotype (L, G_TYPE_MAPPED_FILE, NULL);
+      lgi_record_2c (L, 1, &mapped, FALSE, FALSE, FALSE, FALSE);
+
+      /* Resulting bytes keep the mapping alive. */
+      bytes = g_mapped_file_get_bytes (mapped);
+    }
+
+  data = g_bytes_get_data (bytes, &size);
+  view_push (L, bytes, data, size);
+  return 1;
+}
+
 static const luaL_Reg buffer_reg[] = {
   { "new", buffer_new },
+  { "view", view_new },
   { NULL, NULL }
 };
 
@@ -96,6 +347,13 @@ lgi_buffer_init (lua_State *L)
   luaL_newmetatable (L, LGI_BYTES_BUFFER);
   luaL_register (L, NULL, buffer_mt_reg);
   lua_pop (L, 1);
+  luaL_newmetatable (L, LGI_BYTES_VIEW);
+  luaL_register (L, NULL, view_mt_reg);
+  lua_newtable (L);
+  luaL_register (L, NULL, view_methods_reg);
+  lua_pushcclosure (L, view_index, 1);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
 
   /* Register global API. */
   lua_newtable (L);
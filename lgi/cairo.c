@@ -0,0 +1,466 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native helpers for cairo override.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+/* lgi does not link cairo, so its functions are resolved from the
+   cairo module table passed from Lua, and used structures are
+   declared here. */
+typedef struct _CairoRectangleInt
+{
+  int x, y, width, height;
+} CairoRectangleInt;
+
+typedef struct _CairoRegionApi
+{
+  int (*num_rectangles) (gpointer region);
+  void (*get_rectangle) (gpointer region, int nth, CairoRectangleInt *rect);
+  gpointer (*create_rectangles) (const CairoRectangleInt *rects, int count);
+} CairoRegionApi;
+
+typedef struct _CairoGlyph
+{
+  unsigned long index;
+  double x, y;
+} CairoGlyph;
+
+/* Userdata of glyph buffer, holding packed array of cairo_glyph_t. */
+#define LGI_CAIRO_GLYPHS "lgi.cairo.glyphs"
+typedef struct _GlyphBuffer
+{
+  gsize n_glyphs;
+  CairoGlyph *glyphs;
+} GlyphBuffer;
+
+static void
+region_api_load (lua_State *L, int narg, CairoRegionApi *api)
+{
+  api->num_rectangles =
+    lgi_gi_load_function (L, narg, "cairo_region_num_rectangles");
+  api->get_rectangle =
+    lgi_gi_load_function (L, narg, "cairo_region_get_rectangle");
+  api->create_rectangles =
+    lgi_gi_load_function (L, narg, "cairo_region_create_rectangles");
+  if (api->num_rectangles == NULL || api->get_rectangle == NULL
+      || api->create_rectangles == NULL)
+    luaL_error (L, "cairo region symbols are not available");
+}
+
+/* Retrieves element at 1-based index of the array at narg, which must
+   be a number. */
+static lua_Number
+array_number (lua_State *L, int narg, int index)
+{
+  lua_Number value;
+  lua_rawgeti (L, narg, index);
+  if (lua_type (L, -1) != LUA_TNUMBER)
+    luaL_argerror (L, narg, lua_pushfstring (L, "number expected at index %d",
+					     index));
+  value = lua_tonumber (L, -1);
+  lua_pop (L, 1);
+  return value;
+}
+
+/* points = core.cairo.transform_points(points, xx, yx, xy, yy, x0, y0[,
+   distance]), transforms flat array of coordinates { x1, y1, x2, y2,
+   ... } or bytes.bytearray of packed doubles in place. */
+static int
+cairo_transform_points (lua_State *L)
+{
+  gdouble xx = luaL_checknumber (L, 2), yx = luaL_checknumber (L, 3);
+  gdouble xy = luaL_checknumber (L, 4), yy = luaL_checknumber (L, 5);
+  gdouble x0 = luaL_checknumber (L, 6), y0 = luaL_checknumber (L, 7);
+  gdouble *buffer, x, y;
+  size_t i, n;
+
+  if (lua_toboolean (L, 8))
+    x0 = y0 = 0;
+
+  buffer = lgi_udata_test (L, 1, LGI_BYTES_BUFFER);
+  if (buffer != NULL)
+    {
+      n = lua_objlen (L, 1);
+      luaL_argcheck (L, n % (2 * sizeof (gdouble)) == 0, 1,
+		     "incomplete point in bytearray");
+      n /= 2 * sizeof (gdouble);
+      for (i = 0; i < n; i++, buffer += 2)
+	{
+	  x = buffer[0];
+	  y = buffer[1];
+	  buffer[0] = xx * x + xy * y + x0;
+	  buffer[1] = yx * x + yy * y + y0;
+	}
+    }
+  else
+    {
+      luaL_checktype (L, 1, LUA_TTABLE);
+      n = lua_objlen (L, 1);
+      luaL_argcheck (L, n % 2 == 0, 1, "incomplete point in array");
+      n /= 2;
+      for (i = 0; i < n; i++)
+	{
+	  x = array_number (L, 1, 2 * i + 1);
+	  y = array_number (L, 1, 2 * i + 2);
+	  lua_pushnumber (L, xx * x + xy * y + x0);
+	  lua_rawseti (L, 1, 2 * i + 1);
+	  lua_pushnumber (L, yx * x + yy * y + y0);
+	  lua_rawseti (L, 1, 2 * i + 2);
+	}
+    }
+
+  lua_settop (L, 1);
+  return 1;
+}
+
+/* rects = core.cairo.region_rectangles(module, Region, region),
+   returns flat array { x1, y1, width1, height1, x2, ... }. */
+static int
+cairo_region_rectangles (lua_State *L)
+{
+  CairoRegionApi api;
+  CairoRectangleInt rect;
+  gpointer region;
+  int i, n;
+
+  region_api_load (L, 1, &api);
+  lua_pushvalue (L, 2);
+  lgi_record_2c (L, 3, &region, FALSE, FALSE, FALSE, FALSE);
+  n = api.num_rectangles (region);
+  lua_createtable (L, 4 * n, 0);
+  for (i = 0; i < n; i++)
+    {
+      api.get_rectangle (region, i, &rect);
+      lua_pushinteger (L, rect.x);
+      lua_rawseti (L, -2, 4 * i + 1);
+      lua_pushinteger (L, rect.y);
+      lua_rawseti (L, -2, 4 * i + 2);
+      lua_pushinteger (L, rect.width);
+      lua_rawseti (L, -2, 4 * i + 3);
+      lua_pushinteger (L, rect.height);
+      lua_rawseti (L, -2, 4 * i + 4);
+    }
+  return 1;
+}
+
+/* region = core.cairo.region_create(module, Region, rects), where
+   rects is either flat array { x1, y1, width1, height1, x2, ... } or
+   bytes.bytearray of packed 32bit integers. */
+static int
+cairo_region_create (lua_State *L)
+{
+  CairoRegionApi api;
+  CairoRectangleInt *rects;
+  int i, n;
+
+  region_api_load (L, 1, &api);
+  rects = lgi_udata_test (L, 3, LGI_BYTES_BUFFER);
+  if (rects != NULL)
+    {
+      n = lua_objlen (L, 3);
+      luaL_argcheck (L, n % sizeof (CairoRectangleInt) == 0, 3,
+		     "incomplete rectangle in bytearray");
+      n /= sizeof (CairoRectangleInt);
+    }
+  else
+    {
+      luaL_checktype (L, 3, LUA_TTABLE);
+      n = lua_objlen (L, 3);
+      luaL_argcheck (L, n % 4 == 0, 3, "incomplete rectangle in array");
+      n /= 4;
+      rects = lua_newuserdata (L, n * sizeof (CairoRectangleInt));
+      for (i = 0; i < 4 * n; i++)
+	((int *) rects)[i] = (int) array_number (L, 3, i + 1);
+    }
+
+  lua_pushvalue (L, 2);
+  lgi_record_2lua (L, api.create_rectangles (rects, n), TRUE, 0);
+  return 1;
+}
+
+/* Resizes the glyph buffer, newly added glyphs are zeroed. */
+static void
+glyphs_resize (GlyphBuffer *buffer, gsize n_glyphs)
+{
+  buffer->glyphs = g_renew (CairoGlyph, buffer->glyphs, n_glyphs);
+  if (n_glyphs > buffer->n_glyphs)
+    memset (buffer->glyphs + buffer->n_glyphs, 0,
+	    (n_glyphs - buffer->n_glyphs) * sizeof (CairoGlyph));
+  buffer->n_glyphs = n_glyphs;
+}
+
+/* Stores glyphs from the source at narg into the buffer starting at
+   0-based position 'pos', growing the buffer if needed.  Source is
+   either flat array { index1, x1, y1, index2, ... }, bytes.bytearray
+   of packed cairo_glyph_t or another glyph buffer. */
+static void
+glyphs_fill (lua_State *L, GlyphBuffer *buffer, int narg, gsize pos)
+{
+  GlyphBuffer *other;
+  gpointer data;
+  gsize i, n;
+
+  if ((other = lgi_udata_test (L, narg, LGI_CAIRO_GLYPHS)) != NULL)
+    {
+      /* Source can be the buffer itself, so remember its size before
+	 resizing. */
+      n = other->n_glyphs;
+      if (pos + n > buffer->n_glyphs)
+	glyphs_resize (buffer, pos + n);
+      memmove (buffer->glyphs + pos, other->glyphs, n * sizeof (CairoGlyph));
+    }
+  else if ((data = lgi_udata_test (L, narg, LGI_BYTES_BUFFER)) != NULL)
+    {
+      n = lua_objlen (L, narg);
+      luaL_argcheck (L, n % sizeof (CairoGlyph) == 0, narg,
+		     "incomplete glyph in bytearray");
+      n /= sizeof (CairoGlyph);
+      if (pos + n > buffer->n_glyphs)
+	glyphs_resize (buffer, pos + n);
+      memcpy (buffer->glyphs + pos, data, n * sizeof (CairoGlyph));
+    }
+  else
+    {
+      luaL_checktype (L, narg, LUA_TTABLE);
+      n = lua_objlen (L, narg);
+      luaL_argcheck (L, n % 3 == 0, narg, "incomplete glyph in array");
+      n /= 3;
+      if (pos + n > buffer->n_glyphs)
+	glyphs_resize (buffer, pos + n);
+      for (i = 0; i < n; i++)
+	{
+	  CairoGlyph *glyph = &buffer->glyphs[pos + i];
+	  glyph->index = (unsigned long) array_number (L, narg, 3 * i + 1);
+	  glyph->x = array_number (L, narg, 3 * i + 2);
+	  glyph->y = array_number (L, narg, 3 * i + 3);
+	}
+    }
+}
+
+/* Retrieves glyph buffer at narg.  If there is a plain array or
+   bytearray instead, temporary buffer is created from it and
+   replaces the source on the stack. */
+static GlyphBuffer *
+glyphs_get (lua_State *L, int narg)
+{
+  GlyphBuffer *buffer = lgi_udata_test (L, narg, LGI_CAIRO_GLYPHS);
+  if (buffer == NULL)
+    {
+      buffer = lua_newuserdata (L, sizeof (GlyphBuffer));
+      buffer->n_glyphs = 0;
+      buffer->glyphs = NULL;
+      luaL_getmetatable (L, LGI_CAIRO_GLYPHS);
+      lua_setmetatable (L, -2);
+      glyphs_fill (L, buffer, narg, 0);
+      lua_replace (L, narg);
+    }
+  return buffer;
+}
+
+/* glyphs = core.cairo.glyphs([source | count]) */
+static int
+glyphs_new (lua_State *L)
+{
+  GlyphBuffer *buffer = lua_newuserdata (L, sizeof (GlyphBuffer));
+  buffer->n_glyphs = 0;
+  buffer->glyphs = NULL;
+  luaL_getmetatable (L, LGI_CAIRO_GLYPHS);
+  lua_setmetatable (L, -2);
+  if (lua_type (L, 1) == LUA_TNUMBER)
+    {
+      lua_Integer n = luaL_checkinteger (L, 1);
+      luaL_argcheck (L, n >= 0, 1, "negative size");
+      glyphs_resize (buffer, n);
+    }
+  else if (!lua_isnoneornil (L, 1))
+    glyphs_fill (L, buffer, 1, 0);
+  return 1;
+}
+
+static int
+glyphs_gc (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  g_free (buffer->glyphs);
+  buffer->glyphs = NULL;
+  buffer->n_glyphs = 0;
+  return 0;
+}
+
+static int
+glyphs_len (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_pushinteger (L, buffer->n_glyphs);
+  return 1;
+}
+
+static int
+glyphs_tostring (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_pushfstring (L, "lgi.cairo.glyphs: %p[%d]", buffer,
+		   (int) buffer->n_glyphs);
+  return 1;
+}
+
+/* glyphs:fill(source[, pos]), pos is 1-based and defaults to 1. */
+static int
+glyphs_fill_method (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_Integer pos = luaL_optinteger (L, 3, 1);
+  luaL_argcheck (L, pos >= 1 && (gsize) pos <= buffer->n_glyphs + 1, 3,
+		 "position out of range");
+  glyphs_fill (L, buffer, 2, pos - 1);
+  lua_settop (L, 1);
+  return 1;
+}
+
+/* glyphs:resize(count) */
+static int
+glyphs_resize_method (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_Integer n = luaL_checkinteger (L, 2);
+  luaL_argcheck (L, n >= 0, 2, "negative size");
+  glyphs_resize (buffer, n);
+  lua_settop (L, 1);
+  return 1;
+}
+
+/* index, x, y = glyphs:get(i) */
+static int
+glyphs_get_method (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_Integer i = luaL_checkinteger (L, 2);
+  if (i < 1 || (gsize) i > buffer->n_glyphs)
+    return 0;
+
+  lua_pushnumber (L, buffer->glyphs[i - 1].index);
+  lua_pushnumber (L, buffer->glyphs[i - 1].x);
+  lua_pushnumber (L, buffer->glyphs[i - 1].y);
+  return 3;
+}
+
+/* glyphs:set(i, index, x, y), grows the buffer when i == #glyphs + 1. */
+static int
+glyphs_set_method (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_Integer i = luaL_checkinteger (L, 2);
+  CairoGlyph *glyph;
+  luaL_argcheck (L, i >= 1 && (gsize) i <= buffer->n_glyphs + 1, 2,
+		 "position out of range");
+  if ((gsize) i > buffer->n_glyphs)
+    glyphs_resize (buffer, i);
+
+  glyph = &buffer->glyphs[i - 1];
+  glyph->index = (unsigned long) luaL_checknumber (L, 3);
+  glyph->x = luaL_checknumber (L, 4);
+  glyph->y = luaL_checknumber (L, 5);
+  return 0;
+}
+
+/* glyphs:translate(dx, dy), offsets positions of all glyphs. */
+static int
+glyphs_translate_method (lua_State *L)
+{
+  GlyphBuffer *buffer = luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  gdouble dx = luaL_checknumber (L, 2), dy = luaL_checknumber (L, 3);
+  gsize i;
+  for (i = 0; i < buffer->n_glyphs; i++)
+    {
+      buffer->glyphs[i].x += dx;
+      buffer->glyphs[i].y += dy;
+    }
+  lua_settop (L, 1);
+  return 1;
+}
+
+static int
+glyphs_index (lua_State *L)
+{
+  luaL_checkudata (L, 1, LGI_CAIRO_GLYPHS);
+  lua_pushvalue (L, 2);
+  lua_rawget (L, lua_upvalueindex (1));
+  return 1;
+}
+
+static const luaL_Reg glyphs_reg[] = {
+  { "__gc", glyphs_gc },
+  { "__len", glyphs_len },
+  { "__tostring", glyphs_tostring },
+  { NULL, NULL }
+};
+
+static const luaL_Reg glyphs_methods_reg[] = {
+  { "fill", glyphs_fill_method },
+  { "resize", glyphs_resize_method },
+  { "get", glyphs_get_method },
+  { "set", glyphs_set_method },
+  { "translate", glyphs_translate_method },
+  { NULL, NULL }
+};
+
+/* extents = core.cairo.glyphs_call(module, name, Type, target, glyphs[,
+   TextExtents]), invokes cairo function 'name' on target of record
+   type 'Type' with the glyphs.  When TextExtents typetable is given,
+   new extents record is passed to the function and returned. */
+static int
+cairo_glyphs_call (lua_State *L)
+{
+  void (*func) (gpointer target, const CairoGlyph *glyphs, int num_glyphs,
+		gpointer extents);
+  GlyphBuffer *buffer;
+  gpointer target, extents = NULL;
+
+  func = lgi_gi_load_function (L, 1, luaL_checkstring (L, 2));
+  if (func == NULL)
+    return luaL_error (L, "cairo symbol `%s' is not available",
+		       lua_tostring (L, 2));
+
+  lua_pushvalue (L, 3);
+  lgi_record_2c (L, 4, &target, FALSE, FALSE, FALSE, FALSE);
+  buffer = glyphs_get (L, 5);
+  if (!lua_isnoneornil (L, 6))
+    {
+      lua_pushvalue (L, 6);
+      extents = lgi_record_new (L, 1, FALSE);
+    }
+  func (target, buffer->glyphs, buffer->n_glyphs, extents);
+  return extents != NULL ? 1 : 0;
+}
+
+static const luaL_Reg cairo_reg[] = {
+  { "transform_points", cairo_transform_points },
+  { "region_rectangles", cairo_region_rectangles },
+  { "region_create", cairo_region_create },
+  { "glyphs", glyphs_new },
+  { "glyphs_call", cairo_glyphs_call },
+  { NULL, NULL }
+};
+
+void
+lgi_cairo_init (lua_State *L)
+{
+  /* Register glyph buffer metatable. */
+  luaL_newmetatable (L, LGI_CAIRO_GLYPHS);
+  luaL_register (L, NULL, glyphs_reg);
+  lua_newtable (L);
+  luaL_register (L, NULL, glyphs_methods_reg);
+  lua_pushcclosure (L, glyphs_index, 1);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
+
+  lua_newtable (L);
+  luaL_register (L, NULL, cairo_reg);
+  lua_setfield (L, -2, "cairo");
+}
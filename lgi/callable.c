@@ -65,6 +65,10 @@ typedef struct _Param
   /* Index into env table attached to the callable, contains repotype
      table for specified argument. */
   guint repotype_index : 4;
+
+  /* Set for integer input parameter holding length of the preceding
+     utf8 parameter, which is filled automatically when omitted. */
+  guint string_length : 1;
 } Param;
 
 /* Structure representing userdata allocated for any callable, i.e. function,
@@ -101,6 +105,21 @@ typedef struct _Callable
 /* Address is lightuserdata of Callable metatable in Lua registry. */
 static int callable_mt;
 
+/* Address is lightuserdata of bound callable metatable in Lua
+   registry. */
+static int bound_mt;
+
+/* Method callable with preresolved 'self' argument.  For callables
+   parsed from table description, 'self' is their first argument,
+   which must be a record passed by reference.  Its env table
+   contains the callable at index 1 and the instance proxy at index
+   2, keeping both of them alive. */
+typedef struct _Bound
+{
+  Callable *callable;
+  gpointer self;
+} Bound;
+
 /* Lua thread that can be used for argument marshaling if needed.
  * This address is used as a lightuserdata index in the registry. */
 static int marshalling_L_address;
@@ -277,6 +296,60 @@ callable_mark_array_length (Callable *callable, GITypeInfo *ti)
     }
 }
 
+/* Checks whether parameter is an utf8 string. */
+static gboolean
+callable_is_string (Param *param)
+{
+  return !param->internal && param->kind == PARAM_KIND_TI && param->ti
+    && g_type_info_get_tag (param->ti) == GI_TYPE_TAG_UTF8;
+}
+
+/* Checks whether parameter is an integer holding length of some
+   string, judging from its name. */
+static gboolean
+callable_is_length (Param *param)
+{
+  const gchar *name;
+  if (param->internal || !param->has_arg_info)
+    return FALSE;
+
+  switch (g_type_info_get_tag (param->ti))
+    {
+    case GI_TYPE_TAG_INT32:
+    case GI_TYPE_TAG_UINT32:
+    case GI_TYPE_TAG_INT64:
+    case GI_TYPE_TAG_UINT64:
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  name = g_base_info_get_name (&param->ai);
+  return !strcmp (name, "len") || !strcmp (name, "length")
+    || g_str_has_suffix (name, "_len") || g_str_has_suffix (name, "_length");
+}
+
+/* Marks integer input parameters holding length of the preceding
+   utf8 input parameter.  Output strings are not paired, because
+   typelibs do not tie them to any length and guessing from names is
+   not reliable. */
+static void
+callable_mark_string_length (Callable *callable)
+{
+  Param *param;
+  gint argi;
+
+  for (argi = 0; argi + 1 < callable->nargs; argi++)
+    {
+      param = &callable->params[argi];
+      if (param->dir == GI_DIRECTION_IN && callable_is_string (param)
+	  && callable_is_length (param + 1)
+	  && param[1].dir == GI_DIRECTION_IN)
+	param[1].string_length = TRUE;
+    }
+}
+
 static void
 callable_param_init (Param *param)
 {
@@ -288,6 +361,7 @@ callable_param_init (Param *param)
   param->call_scoped_user_data = FALSE;
   param->kind = PARAM_KIND_TI;
   param->repotype_index = 0;
+  param->string_length = FALSE;
 }
 
 static Callable *
@@ -427,6 +501,9 @@ lgi_callable_create (lua_State *L, GICallableInfo *info, gpointer addr)
       callable->params[2].internal = 1;
     }
 
+  /* Find lengths of string arguments. */
+  callable_mark_string_length (callable);
+
   /* Add ffi info for 'err' argument. */
   if (callable->throws)
     *ffi_arg++ = &ffi_type_pointer;
@@ -800,8 +877,110 @@ callable_param_2lua (lua_State *L, Param *param, GIArgument *arg,
     }
 }
 
+/* Releases output value of the parameter which is not going to be
+   returned to Lua.  Values which are not owned are just ignored,
+   owned ones are released directly where possible, without creating
+   their Lua-side representation. */
+static void
+callable_param_discard (lua_State *L, Param *param, GIArgument *arg,
+			int parent, Callable *callable, void **args)
+{
+  if (param->transfer == GI_TRANSFER_NOTHING)
+    {
+      /* Proxy would sink floating reference of not owned object and
+	 release it, so do the same to avoid leaking it. */
+      if (param->kind == PARAM_KIND_TI && param->ti
+	  && g_type_info_get_tag (param->ti) == GI_TYPE_TAG_INTERFACE
+	  && arg->v_pointer != NULL)
+	{
+	  GIBaseInfo *ii = g_type_info_get_interface (param->ti);
+	  GIInfoType type = g_base_info_get_type (ii);
+	  if ((type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
+	      && G_IS_INITIALLY_UNOWNED (arg->v_pointer)
+	      && g_object_is_floating (arg->v_pointer))
+	    {
+	      g_object_ref_sink (arg->v_pointer);
+	      g_object_unref (arg->v_pointer);
+	    }
+	  g_base_info_unref (ii);
+	}
+      return;
+    }
+  else if (param->kind == PARAM_KIND_ENUM)
+    return;
+
+  if (param->kind == PARAM_KIND_TI && param->ti)
+    {
+      GITypeTag tag = g_type_info_get_tag (param->ti);
+      if (!g_type_info_is_pointer (param->ti))
+	/* Plain values do not own anything. */
+	return;
+      else if (tag == GI_TYPE_TAG_UTF8 || tag == GI_TYPE_TAG_FILENAME)
+	{
+	  g_free (arg->v_string);
+	  return;
+	}
+      else if (tag == GI_TYPE_TAG_INTERFACE)
+	{
+	  gboolean released = FALSE;
+	  GIBaseInfo *ii = g_type_info_get_interface (param->ti);
+	  GIInfoType type = g_base_info_get_type (ii);
+	  if (arg->v_pointer == NULL)
+	    released = TRUE;
+	  else if ((type == GI_INFO_TYPE_OBJECT
+		    || type == GI_INFO_TYPE_INTERFACE)
+		   && G_IS_OBJECT (arg->v_pointer))
+	    {
+	      g_object_unref (arg->v_pointer);
+	      released = TRUE;
+	    }
+	  else if (type == GI_INFO_TYPE_STRUCT || type == GI_INFO_TYPE_UNION
+		   || type == GI_INFO_TYPE_BOXED)
+	    {
+	      GType gtype = g_registered_type_info_get_g_type (ii);
+	      if (G_TYPE_IS_BOXED (gtype) && gtype != G_TYPE_BOXED)
+		{
+		  g_boxed_free (gtype, arg->v_pointer);
+		  released = TRUE;
+		}
+	    }
+	  g_base_info_unref (ii);
+	  if (released)
+	    return;
+	}
+    }
+
+  /* Fall back to marshalling the value and dropping it, its proxy
+     takes care of releasing it. */
+  callable_param_2lua (L, param, arg, parent, 1, callable, args);
+  lua_pop (L, 1);
+}
+
+/* Unwraps 'self' argument of the method callable from given stack
+   index, checking that it is an instance of the method's container. */
+static gpointer
+callable_self_2c (lua_State *L, Callable *callable, int narg)
+{
+  gpointer self;
+  GIBaseInfo *parent = g_base_info_get_container (callable->info);
+  GIInfoType type = g_base_info_get_type (parent);
+  if (type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
+    return lgi_object_2c (L, narg, g_registered_type_info_get_g_type (parent),
+			  FALSE, FALSE, FALSE);
+
+  lgi_type_get_repotype (L, G_TYPE_INVALID, parent);
+  lgi_record_2c (L, narg, &self, FALSE, FALSE, FALSE, FALSE);
+  return self;
+}
+
+/* Performs the call of the callable at index 1.  If 'self' is not
+   NULL, it is used as already unwrapped 'self' (or first) argument of
+   the method and its proxy at index 2 is not checked again.  If
+   'discard' is set, return value and output arguments are not
+   marshalled to Lua, owned ones are just released. */
 static int
-callable_call (lua_State *L)
+callable_invoke (lua_State *L, Callable *callable, gpointer self,
+		 gboolean discard)
 {
   Param *param;
   int i, lua_argi, nret, caller_allocated = 0, nargs;
@@ -809,7 +988,6 @@ callable_call (lua_State *L)
   void **ffi_args, **redirect_out;
   GError *err = NULL;
   gpointer state_lock = lgi_state_get_lock (L);
-  Callable *callable = callable_get (L, 1);
 
   /* Make sure that all unspecified arguments are set as nil; during
      marshalling we might create temporary values on the stack, which
@@ -831,22 +1009,8 @@ callable_call (lua_State *L)
   nret = 0;
   if (callable->has_self)
     {
-      GIBaseInfo *parent = g_base_info_get_container (callable->info);
-      GIInfoType type = g_base_info_get_type (parent);
-      if (type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
-	{
-	  args[0].v_pointer =
-	    lgi_object_2c (L, 2, g_registered_type_info_get_g_type (parent),
-			   FALSE, FALSE, FALSE);
-	  nret++;
-	}
-      else
-	{
-	  lgi_type_get_repotype (L, G_TYPE_INVALID, parent);
-	  lgi_record_2c (L, 2, &args[0].v_pointer, FALSE, FALSE, FALSE, FALSE);
-	  nret++;
-	}
-
+      args[0].v_pointer = (self != NULL) ? self
+	: callable_self_2c (L, callable, 2);
       ffi_args[0] = &args[0];
       lua_argi++;
     }
@@ -886,9 +1050,24 @@ callable_call (lua_State *L)
     if (!param->internal)
       {
 	int argi = i + callable->has_self;
-	if (param->dir != GI_DIRECTION_OUT)
-	  nret += callable_param_2c (L, param, lua_argi++, 0, &args[argi],
-				     1, callable, ffi_args);
+	if (i == 0 && self != NULL && !callable->has_self)
+	  {
+	    /* First argument was already unwrapped when binding. */
+	    args[0].v_pointer = self;
+	    lua_argi++;
+	  }
+	else if (param->dir != GI_DIRECTION_OUT)
+	  {
+	    /* Fill omitted length from the preceding string. */
+	    if (param->string_length && lua_isnil (L, lua_argi)
+		&& lua_type (L, lua_argi - 1) == LUA_TSTRING)
+	      {
+		lua_pushnumber (L, lua_objlen (L, lua_argi - 1));
+		lua_replace (L, lua_argi);
+	      }
+	    nret += callable_param_2c (L, param, lua_argi++, 0, &args[argi],
+				       1, callable, ffi_args);
+	  }
 	/* Special handling for out/caller-alloc structures; we have to
 	   manually pre-create them and store them on the stack. */
 	else if (callable->info && g_arg_info_is_caller_allocates (&param->ai)
@@ -939,10 +1118,16 @@ callable_call (lua_State *L)
 	  || (g_type_info_get_tag (callable->retval.ti) != GI_TYPE_TAG_VOID
 	      || g_type_info_is_pointer (callable->retval.ti))))
     {
-      callable_param_2lua (L, &callable->retval, &retval, LGI_PARENT_IS_RETVAL,
-			   1, callable, ffi_args);
-      nret++;
-      lua_insert (L, -caller_allocated - 1);
+      if (discard)
+	callable_param_discard (L, &callable->retval, &retval,
+				LGI_PARENT_IS_RETVAL, callable, ffi_args);
+      else
+	{
+	  callable_param_2lua (L, &callable->retval, &retval,
+			       LGI_PARENT_IS_RETVAL, 1, callable, ffi_args);
+	  nret++;
+	  lua_insert (L, -caller_allocated - 1);
+	}
     }
   else if (callable->ignore_retval)
     {
@@ -970,6 +1155,23 @@ callable_call (lua_State *L)
       return nret + 1;
     }
 
+  if (discard)
+    {
+      /* Release owned output parameters.  Caller allocated ones are
+	 owned by their proxies lying on the stack. */
+      param = &callable->params[0];
+      for (i = 0; i < callable->nargs; i++, param++)
+	if (!param->internal && param->dir != GI_DIRECTION_IN
+	    && !(callable->info && g_arg_info_is_caller_allocates (&param->ai)))
+	  callable_param_discard (L, param, &args[i + callable->has_self],
+				  0, callable, ffi_args);
+      lua_pop (L, caller_allocated);
+      if (!callable->throws)
+	return 0;
+      lua_pushboolean (L, 1);
+      return 1;
+    }
+
   /* Process output parameters. */
   param = &callable->params[0];
   for (i = 0; i < callable->nargs; i++, param++)
@@ -1014,6 +1216,95 @@ callable_call (lua_State *L)
   return nret;
 }
 
+/* Returns namespace and name of the callable, used for tracing. */
+static const gchar *
+callable_namespace (Callable *callable)
+{
+  return callable->info ? g_base_info_get_namespace (callable->info) : "";
+}
+
+static const gchar *
+callable_name (Callable *callable)
+{
+  return callable->info ? g_base_info_get_name (callable->info) : "";
+}
+
+/* Arguments of the invocation running in protected mode. */
+typedef struct _CallableInvocation
+{
+  Callable *callable;
+  gpointer self;
+  gboolean discard;
+} CallableInvocation;
+
+static int
+callable_invoke_protected (lua_State *L)
+{
+  CallableInvocation *invocation = lua_touserdata (L, lua_upvalueindex (1));
+  return callable_invoke (L, invocation->callable, invocation->self,
+			  invocation->discard);
+}
+
+/* Invokes the callable while the profiler attributes time to it.
+   Error raised by the call would skip restoring of the attribution,
+   so the call runs protected and the error is rethrown afterwards. */
+static int
+callable_invoke_profiled (lua_State *L, Callable *callable, gpointer self,
+			  gboolean discard, LgiProfileFrame *frame)
+{
+  CallableInvocation invocation;
+  int status;
+
+  invocation.callable = callable;
+  invocation.self = self;
+  invocation.discard = discard;
+  lua_pushlightuserdata (L, &invocation);
+  lua_pushcclosure (L, callable_invoke_protected, 1);
+  lua_insert (L, 1);
+  status = lua_pcall (L, lua_gettop (L) - 1, LUA_MULTRET, 0);
+  LGI_PROFILE_LEAVE (L, frame);
+  if (status != 0)
+    lua_error (L);
+  return lua_gettop (L);
+}
+
+/* Invokes the callable, wrapped in call tracepoints, trace events
+   and profiler attribution. */
+static int
+callable_dispatch (lua_State *L, Callable *callable, gpointer self,
+		   gboolean discard)
+{
+  LgiProfileFrame frame;
+  int nret;
+  LGI_PROBE3 (call__entry, callable_namespace (callable),
+	      callable_name (callable), callable->address);
+  LGI_TRACE (LGI_TRACE_CALLS, 'B', callable_namespace (callable),
+	     callable_name (callable), NULL);
+  LGI_PROFILE_ENTER (L, &frame, callable_namespace (callable),
+		     callable_name (callable));
+  if (G_UNLIKELY (frame.entered))
+    nret = callable_invoke_profiled (L, callable, self, discard, &frame);
+  else
+    nret = callable_invoke (L, callable, self, discard);
+  LGI_TRACE (LGI_TRACE_CALLS, 'E', callable_namespace (callable),
+	     callable_name (callable), NULL);
+  LGI_PROBE3 (call__return, callable_namespace (callable),
+	      callable_name (callable), nret);
+  return nret;
+}
+
+static int
+callable_call (lua_State *L)
+{
+  return callable_dispatch (L, callable_get (L, 1), NULL, FALSE);
+}
+
+static int
+callable_call_void (lua_State *L)
+{
+  return callable_dispatch (L, callable_get (L, 1), NULL, TRUE);
+}
+
 static int
 callable_index (lua_State *L)
 {
@@ -1074,6 +1365,11 @@ callable_index (lua_State *L)
       lua_pushlightuserdata (L, callable->user_data);
       return 1;
     }
+  else if (g_strcmp0 (verb, "call_void") == 0)
+    {
+      lua_pushcfunction (L, callable_call_void);
+      return 1;
+    }
 
   return 0;
 }
@@ -1097,6 +1393,101 @@ static const struct luaL_Reg callable_reg[] = {
   { NULL, NULL }
 };
 
+static Bound *
+bound_get (lua_State *L, int narg)
+{
+  luaL_checkstack (L, 3, "");
+  if (lua_getmetatable (L, narg))
+    {
+      lua_pushlightuserdata (L, &bound_mt);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      if (lua_rawequal (L, -1, -2))
+	{
+	  lua_pop (L, 2);
+	  return lua_touserdata (L, narg);
+	}
+    }
+
+  lua_pushfstring (L, "expected lgi.bound, got %s",
+		   lua_typename (L, lua_type (L, narg)));
+  luaL_argerror (L, narg, lua_tostring (L, -1));
+  return NULL;
+}
+
+/* Prepares the stack for invoking bound callable, returns it. */
+static Bound *
+bound_prepare (lua_State *L)
+{
+  Bound *bound = bound_get (L, 1);
+
+  /* Rearrange the stack to the form expected by callable_invoke,
+     i.e. replace bound with the callable and insert the instance
+     proxy as the first argument. */
+  lua_getfenv (L, 1);
+  lua_rawgeti (L, -1, 2);
+
+  /* Instance proxy loses its metatable when it is finalized; this can
+     happen even when it is referenced, e.g. during state closing. */
+  if (!lua_getmetatable (L, -1))
+    {
+      callable_describe (L, bound->callable, NULL);
+      return luaL_error (L, "%s: bound instance was released",
+			 lua_tostring (L, -1));
+    }
+  lua_pop (L, 1);
+  lua_rawgeti (L, -2, 1);
+  lua_replace (L, 1);
+  lua_insert (L, 2);
+  lua_pop (L, 1);
+  return bound;
+}
+
+static int
+bound_call (lua_State *L)
+{
+  Bound *bound = bound_prepare (L);
+  return callable_dispatch (L, bound->callable, bound->self, FALSE);
+}
+
+static int
+bound_call_void (lua_State *L)
+{
+  Bound *bound = bound_prepare (L);
+  return callable_dispatch (L, bound->callable, bound->self, TRUE);
+}
+
+static int
+bound_index (lua_State *L)
+{
+  bound_get (L, 1);
+  if (g_strcmp0 (lua_tostring (L, 2), "call_void") == 0)
+    {
+      lua_pushcfunction (L, bound_call_void);
+      return 1;
+    }
+
+  return 0;
+}
+
+static int
+bound_tostring (lua_State *L)
+{
+  Bound *bound = bound_get (L, 1);
+  lua_getfenv (L, 1);
+  lua_rawgeti (L, -1, 1);
+  lua_replace (L, 1);
+  callable_describe (L, bound->callable, NULL);
+  lua_pushfstring (L, "lgi.bound %p: %s", bound->self, lua_tostring (L, -1));
+  return 1;
+}
+
+static const struct luaL_Reg bound_reg[] = {
+  { "__call", bound_call },
+  { "__tostring", bound_tostring },
+  { "__index", bound_index },
+  { NULL, NULL }
+};
+
 static int
 marshal_arguments (lua_State *L, void **args, int callable_index, Callable *callable)
 {
@@ -1266,6 +1657,8 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   FfiClosureBlock *block = closure->block;
   gint res = 0, npos, stacktop, extra_args = 0;
   gboolean call;
+  const gchar *location = NULL;
+  LgiProfileFrame frame;
   lua_State *L;
   lua_State *marshal_L;
   (void)cif;
@@ -1300,6 +1693,8 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
 
       /* Store function to be invoked to the stack. */
       lua_rawgeti (L, LUA_REGISTRYINDEX, closure->target_ref);
+      if (G_UNLIKELY (lgi_trace_mask & LGI_TRACE_CALLBACKS))
+	location = lgi_trace_location (L);
     }
   else
     {
@@ -1330,6 +1725,11 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   lua_rawgeti (marshal_L, LUA_REGISTRYINDEX, closure->callable_ref);
   callable = lua_touserdata (marshal_L, -1);
   callable_index = lua_gettop (marshal_L);
+  LGI_PROBE3 (callback__entry, callable_namespace (callable),
+	      callable_name (callable), call);
+  LGI_TRACE (LGI_TRACE_CALLBACKS, 'B', callable_namespace (callable),
+	     callable_name (callable), location);
+  LGI_PROFILE_ENTER (L, &frame, NULL, NULL);
 
   npos = marshal_arguments (marshal_L, args, callable_index, callable);
 
@@ -1408,6 +1808,12 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   if (L != marshal_L)
     lua_settop (marshal_L, 0);
 
+  LGI_PROFILE_LEAVE (L, &frame);
+  LGI_TRACE (LGI_TRACE_CALLBACKS, 'E', callable_namespace (callable),
+	     callable_name (callable), NULL);
+  LGI_PROBE3 (callback__return, callable_namespace (callable),
+	      callable_name (callable), res);
+
   /* Going back to C code, release the state synchronization. */
   lgi_state_leave (block->callback.state_lock);
 }
@@ -1536,9 +1942,54 @@ callable_new (lua_State *L)
 				  addr);
 }
 
+/* Creates callable with preresolved instance of the method. Lua prototype:
+   bound = callable.bind(method_callable, instance) */
+static int
+callable_bind (lua_State *L)
+{
+  Callable *callable = callable_get (L, 1);
+  Param *param = &callable->params[0];
+  Bound *bound;
+  gpointer self;
+
+  /* Unwrap and check the instance once, here. */
+  lua_settop (L, 2);
+  if (callable->has_self)
+    self = callable_self_2c (L, callable, 2);
+  else
+    {
+      luaL_argcheck (L, callable->info == NULL && callable->nargs > 0
+		     && !param->internal && param->dir == GI_DIRECTION_IN
+		     && param->kind == PARAM_KIND_RECORD
+		     && param->transfer == GI_TRANSFER_NOTHING,
+		     1, "method expected");
+      lua_getfenv (L, 1);
+      lua_rawgeti (L, -1, param->repotype_index);
+      lgi_record_2c (L, 2, &self, FALSE, FALSE, FALSE, FALSE);
+      lua_pop (L, 1);
+    }
+
+  bound = lua_newuserdata (L, sizeof (Bound));
+  bound->callable = callable;
+  bound->self = self;
+  lua_pushlightuserdata (L, &bound_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_setmetatable (L, -2);
+
+  /* Keep both callable and the instance alive. */
+  lua_createtable (L, 2, 0);
+  lua_pushvalue (L, 1);
+  lua_rawseti (L, -2, 1);
+  lua_pushvalue (L, 2);
+  lua_rawseti (L, -2, 2);
+  lua_setfenv (L, -2);
+  return 1;
+}
+
 /* Callable module public API table. */
 static const luaL_Reg callable_api_reg[] = {
   { "new", callable_new },
+  { "bind", callable_bind },
   { NULL, NULL }
 };
 
@@ -1557,6 +2008,12 @@ lgi_callable_init (lua_State *L)
   luaL_register (L, NULL, callable_reg);
   lua_rawset (L, LUA_REGISTRYINDEX);
 
+  /* Register bound callable metatable. */
+  lua_pushlightuserdata (L, &bound_mt);
+  lua_newtable (L);
+  luaL_register (L, NULL, bound_reg);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
   /* Create cache for callables. */
   lgi_cache_create (L, &callable_cache, NULL);
 
@@ -128,7 +128,7 @@ end
 -- _element implementation for objects, checks parent and implemented
 -- interfaces if element cannot be found in current typetable.
 local internals = { _native = true, _type = true, _gtype = true,
-		    _class = true, class = true }
+		    _class = true, class = true, _bind = true }
 function class.class_mt:_element(instance, symbol)
    -- Special handling of internal symbols.
    if instance and internals[symbol] then return symbol, symbol end
@@ -167,6 +167,11 @@ function class.class_mt:_access_type(instance)
    return core.object.query(instance, 'repo')
 end
 
+-- Add accessor '_bind' handling.
+function class.class_mt:_access_bind(instance)
+   return component.bind
+end
+
 -- Add accessor '_gtype' handling.
 function class.class_mt:_access_gtype(instance)
    -- Cast address of the instance to TypeInstance to get to type info.
@@ -291,7 +296,7 @@ function class.class_mt:derive(typename, ifaces)
       {
 	 _parent = self, _override = {}, _guard = {}, _implements = {},
 	 _property = {}, _element = class.derived_mt._element,
-	 _property_get = {}, _property_set = {},
+	 _property_get = {}, _property_set = {}, _property_native = {},
 	 _class = self._class, _name = typename
       },
       class.derived_mt)
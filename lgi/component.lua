@@ -307,6 +307,18 @@ function component.mt:__tostring()
    return self._name
 end
 
+-- Returns callable which invokes method 'name' on given instance.
+-- Native methods are bound with the instance unwrapped and checked
+-- only once, instead of on every call.
+local function bind(instance, name)
+   local method = instance[name]
+   if type(method) == 'userdata' then
+      return core.callable.bind(method, instance)
+   end
+   return function(...) return method(instance, ...) end
+end
+component.bind = bind
+
 -- Creates new component and sets up common parts according to given
 -- info.
 function component.create(info, mt, name)
@@ -37,6 +37,21 @@
 
 volatile gint global_state_id = 0;
 
+#ifdef LGI_ENABLE_USDT
+/* Semaphores of static tracepoints, updated by attaching tools. */
+#define LGI_PROBE_DEFINE(name)						\
+  volatile unsigned short LGI_PROBE_SEMAPHORE (name)			\
+  __attribute__ ((section (".probes")))
+LGI_PROBE_DEFINE (call__entry);
+LGI_PROBE_DEFINE (call__return);
+LGI_PROBE_DEFINE (callback__entry);
+LGI_PROBE_DEFINE (callback__return);
+LGI_PROBE_DEFINE (state__enter);
+LGI_PROBE_DEFINE (object__2lua);
+LGI_PROBE_DEFINE (object__gc);
+LGI_PROBE_DEFINE (record__gc);
+#endif
+
 #ifndef NDEBUG
 const char *lgi_sd (lua_State *L)
 {
@@ -346,6 +361,9 @@ lgi_state_enter (gpointer state_lock)
 {
   LgiStateMutex *mutex = state_lock;
   GRecMutex *wait_on;
+#ifdef LGI_ENABLE_USDT
+  gint64 wait = 0;
+#endif
 
   /* There is a complication with lock switching.  During the wait for
      the lock, someone could call core.registerlock() and thus change
@@ -353,13 +371,28 @@ lgi_state_enter (gpointer state_lock)
   for (;;)
     {
       wait_on = g_atomic_pointer_get (&mutex->mutex);
+#ifdef LGI_ENABLE_USDT
+      /* Measure the time spent waiting, only when the probe is
+	 attached and the lock is contended. */
+      if (!LGI_PROBE_ENABLED (state__enter))
+	g_rec_mutex_lock (wait_on);
+      else if (!g_rec_mutex_trylock (wait_on))
+	{
+	  gint64 start = g_get_monotonic_time ();
+	  g_rec_mutex_lock (wait_on);
+	  wait += g_get_monotonic_time () - start;
+	}
+#else
       g_rec_mutex_lock (wait_on);
+#endif
       if (wait_on == mutex->mutex)
 	break;
 
       /* The lock is changed, unlock this one and wait again. */
       g_rec_mutex_unlock (wait_on);
     }
+
+  LGI_PROBE2 (state__enter, state_lock, wait);
 }
 
 void
@@ -774,6 +807,19 @@ luaopen_lgi_corelgilua51 (lua_State* L)
   lgi_record_init (L);
   lgi_object_init (L);
   lgi_callable_init (L);
+  lgi_gio_init (L);
+  lgi_gtk_init (L);
+  lgi_poll_init (L);
+  lgi_schedule_init (L);
+  lgi_sort_init (L);
+  lgi_variant_init (L);
+  lgi_binding_init (L);
+  lgi_cairo_init (L);
+  lgi_trace_init (L);
+  lgi_profile_init (L);
+#ifdef LGI_EMBED_LUA
+  lgi_embed_init (L);
+#endif
 
   /* Return registration table. */
   return 1;
@@ -0,0 +1,84 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Loading of lgi Lua modules precompiled into the core module.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "lgi.h"
+
+/* Single precompiled module. */
+typedef struct _EmbeddedModule
+{
+  const char *name;
+  const unsigned char *code;
+  size_t size;
+} EmbeddedModule;
+
+/* Generated by tools/embed-lua.lua, defines embedded_modules[] sorted
+   by module name. */
+#include "embedded.h"
+
+static int
+embed_compare (const void *name, const void *module)
+{
+  return strcmp (name, ((const EmbeddedModule *) module)->name);
+}
+
+/* Searcher for package.loaders/searchers, returns loader of the
+   embedded module. */
+static int
+embed_searcher (lua_State *L)
+{
+  const char *name = luaL_checkstring (L, 1);
+  const EmbeddedModule *module =
+    bsearch (name, embedded_modules, G_N_ELEMENTS (embedded_modules),
+	     sizeof (EmbeddedModule), embed_compare);
+  if (module == NULL)
+    {
+      lua_pushfstring (L, "\n\tno embedded module '%s'", name);
+      return 1;
+    }
+
+  if (luaL_loadbuffer (L, (const char *) module->code, module->size,
+		       module->name) != 0)
+    return luaL_error (L, "error loading embedded module '%s':\n\t%s",
+		       name, lua_tostring (L, -1));
+  return 1;
+}
+
+void
+lgi_embed_init (lua_State *L)
+{
+  int i;
+
+  /* Install our searcher right after the preload one, so that
+     embedded modules are found without touching the filesystem. */
+  lua_getglobal (L, "package");
+  if (!lua_istable (L, -1))
+    {
+      lua_pop (L, 1);
+      return;
+    }
+  lua_getfield (L, -1, "searchers");
+  if (!lua_istable (L, -1))
+    {
+      lua_pop (L, 1);
+      lua_getfield (L, -1, "loaders");
+    }
+  if (lua_istable (L, -1))
+    {
+      for (i = lua_objlen (L, -1); i >= 2; i--)
+	{
+	  lua_rawgeti (L, -1, i);
+	  lua_rawseti (L, -2, i + 1);
+	}
+      lua_pushcfunction (L, embed_searcher);
+      lua_rawseti (L, -2, 2);
+    }
+  lua_pop (L, 2);
+}
@@ -0,0 +1,830 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native helpers for Gio overrides.
+ */
+
+#include <string.h>
+#include <gio/gio.h>
+#include "lgi.h"
+
+/* Pushes value of given attribute of the info to the stack, or nil if
+   the info does not contain such attribute. */
+static void
+fileinfo_push_attribute (lua_State *L, GFileInfo *info, const char *attr)
+{
+  switch (g_file_info_get_attribute_type (info, attr))
+    {
+    case G_FILE_ATTRIBUTE_TYPE_STRING:
+      lua_pushstring (L, g_file_info_get_attribute_string (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_BYTE_STRING:
+      lua_pushstring (L, g_file_info_get_attribute_byte_string (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_BOOLEAN:
+      lua_pushboolean (L, g_file_info_get_attribute_boolean (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_UINT32:
+      lua_pushnumber (L, g_file_info_get_attribute_uint32 (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_INT32:
+      lua_pushnumber (L, g_file_info_get_attribute_int32 (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_UINT64:
+      lua_pushnumber (L, g_file_info_get_attribute_uint64 (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_INT64:
+      lua_pushnumber (L, g_file_info_get_attribute_int64 (info, attr));
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_OBJECT:
+      lgi_object_2lua (L, g_file_info_get_attribute_object (info, attr),
+		       FALSE, FALSE);
+      break;
+
+    case G_FILE_ATTRIBUTE_TYPE_STRINGV:
+      {
+	char **strv = g_file_info_get_attribute_stringv (info, attr);
+	int i;
+	lua_newtable (L);
+	for (i = 0; strv && strv[i]; i++)
+	  {
+	    lua_pushstring (L, strv[i]);
+	    lua_rawseti (L, -2, i + 1);
+	  }
+	break;
+      }
+
+    default:
+      lua_pushnil (L);
+    }
+}
+
+/* Converts list of GFileInfo instances into table of plain Lua
+   records, containing attributes listed in the table at 'attrs'
+   index.  Consumes the list. */
+static int
+fileinfo_push_list (lua_State *L, GList *list, int attrs)
+{
+  GList *item;
+  int i, index = 1, n_attrs = lua_objlen (L, attrs);
+
+  lua_createtable (L, g_list_length (list), 0);
+  for (item = list; item != NULL; item = item->next)
+    {
+      lua_createtable (L, 0, n_attrs);
+      for (i = 1; i <= n_attrs; i++)
+	{
+	  lua_rawgeti (L, attrs, i);
+	  fileinfo_push_attribute (L, item->data, lua_tostring (L, -1));
+	  lua_rawset (L, -3);
+	}
+      lua_rawseti (L, -2, index++);
+      g_object_unref (item->data);
+    }
+
+  g_list_free (list);
+  return 1;
+}
+
+/* Pushes GLib.Error instance wrapping given error, preceded by nil. */
+static int
+gio_push_error (lua_State *L, GError *err)
+{
+  lua_pushnil (L);
+  lgi_type_get_repotype (L, G_TYPE_ERROR, NULL);
+  lgi_record_2lua (L, err, TRUE, 0);
+  return 2;
+}
+
+/* Checks that arg at narg is table containing only attribute names. */
+static void
+gio_check_attrs (lua_State *L, int narg)
+{
+  int i;
+  luaL_checktype (L, narg, LUA_TTABLE);
+  for (i = 1; i <= (int) lua_objlen (L, narg); i++)
+    {
+      lua_rawgeti (L, narg, i);
+      if (lua_type (L, -1) != LUA_TSTRING)
+	luaL_argerror (L, narg, "attribute names expected");
+      lua_pop (L, 1);
+    }
+}
+
+/* files = core.gio.next_batch(enumerator, n, attrs[, cancellable]) */
+static int
+gio_next_batch (lua_State *L)
+{
+  GList *list;
+  GError *err = NULL;
+  gpointer state_lock = lgi_state_get_lock (L);
+  GFileEnumerator *enumerator =
+    lgi_object_2c (L, 1, G_TYPE_FILE_ENUMERATOR, FALSE, FALSE, FALSE);
+  int n = luaL_checkint (L, 2);
+  GCancellable *cancellable =
+    lgi_object_2c (L, 4, G_TYPE_CANCELLABLE, TRUE, FALSE, FALSE);
+  luaL_argcheck (L, n >= 0, 2, "negative number of files");
+  gio_check_attrs (L, 3);
+
+  /* Enumeration performs blocking I/O, so leave the state for the
+     time of the call. */
+  lgi_state_leave (state_lock);
+  list = g_file_enumerator_next_files (enumerator, n, cancellable, &err);
+  lgi_state_enter (state_lock);
+
+  if (err != NULL)
+    return gio_push_error (L, err);
+  return fileinfo_push_list (L, list, 3);
+}
+
+/* files = core.gio.next_batch_finish(enumerator, result, attrs) */
+static int
+gio_next_batch_finish (lua_State *L)
+{
+  GList *list;
+  GError *err = NULL;
+  GFileEnumerator *enumerator =
+    lgi_object_2c (L, 1, G_TYPE_FILE_ENUMERATOR, FALSE, FALSE, FALSE);
+  GAsyncResult *result =
+    lgi_object_2c (L, 2, G_TYPE_ASYNC_RESULT, FALSE, FALSE, FALSE);
+  gio_check_attrs (L, 3);
+
+  list = g_file_enumerator_next_files_finish (enumerator, result, &err);
+  if (err != NULL)
+    return gio_push_error (L, err);
+  return fileinfo_push_list (L, list, 3);
+}
+
+/* Per-class data of buffered stream classes. */
+typedef struct _BufferedClass
+{
+  /* Thread used for calling Lua methods and state lock. */
+  lua_State *L;
+  int thread_ref;
+  gpointer state_lock;
+
+  /* Size of the buffer passed to Lua methods. */
+  gsize chunk_size;
+
+  /* Reference to bytes.bytearray passed to do_fill, LUA_NOREF until
+     it is needed, and flag whether it is currently being filled. */
+  int buffer_ref;
+  gboolean buffer_busy;
+} BufferedClass;
+
+/* Per-instance buffer of buffered streams.  It does not reference
+   anything in the Lua state, because the stream can outlive it. */
+typedef struct _BufferedStream
+{
+  BufferedClass *klass;
+
+  /* Buffered data, allocated together with the structure. */
+  guint8 *data;
+
+  /* Position of unread data in input stream, length of valid data. */
+  gsize pos, len;
+} BufferedStream;
+
+static GQuark buffered_quark;
+
+/* Finds buffered class data of the instance, searching also parent
+   types, because Lua-derived classes can be derived further. */
+static BufferedClass *
+buffered_class_get (gpointer instance)
+{
+  GType gtype;
+  for (gtype = G_TYPE_FROM_INSTANCE (instance); gtype != G_TYPE_INVALID;
+       gtype = g_type_parent (gtype))
+    {
+      BufferedClass *klass = g_type_get_qdata (gtype, buffered_quark);
+      if (klass != NULL)
+	return klass;
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+/* Prepares thread for calling Lua from klass, must be called inside
+   the state lock. */
+static lua_State *
+buffered_thread (BufferedClass *klass)
+{
+  lua_State *L = klass->L;
+  if (lua_status (L) != 0)
+    {
+      /* Thread is suspended, we cannot use it for calling, so replace
+	 it with new one. */
+      L = lua_newthread (L);
+      lua_rawseti (klass->L, LUA_REGISTRYINDEX, klass->thread_ref);
+      klass->L = L;
+    }
+  return L;
+}
+
+/* Retrieves buffer of the stream, allocating it on the first access. */
+static BufferedStream *
+buffered_stream_get (gpointer stream)
+{
+  BufferedStream *bs = g_object_get_qdata (stream, buffered_quark);
+  if (bs == NULL)
+    {
+      BufferedClass *klass = buffered_class_get (stream);
+      bs = g_malloc0 (sizeof (BufferedStream) + klass->chunk_size);
+      bs->klass = klass;
+      bs->data = (guint8 *) (bs + 1);
+      g_object_set_qdata_full (stream, buffered_quark, bs, g_free);
+    }
+  return bs;
+}
+
+/* Pushes bytearray to be filled by do_fill.  Class buffer is reused,
+   unless it is being filled by outer call on another stream. */
+static void
+buffered_push_buffer (lua_State *L, BufferedClass *klass)
+{
+  if (klass->buffer_ref != LUA_NOREF && !klass->buffer_busy)
+    lua_rawgeti (L, LUA_REGISTRYINDEX, klass->buffer_ref);
+  else
+    {
+      lua_newuserdata (L, klass->chunk_size);
+      luaL_getmetatable (L, LGI_BYTES_BUFFER);
+      lua_setmetatable (L, -2);
+      if (klass->buffer_ref == LUA_NOREF)
+	{
+	  lua_pushvalue (L, -1);
+	  klass->buffer_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+	}
+    }
+}
+
+/* Invokes do_fill(buffer) method of input stream, when 'fill' is
+   TRUE, otherwise do_drain(data) of output stream with buffered data
+   as string.  Method signals failure by returning false or nil
+   followed by GLib.Error or message.  Returns FALSE on failure,
+   otherwise stores number of bytes filled into bs->len. */
+static gboolean
+buffered_call (BufferedStream *bs, gpointer stream, gboolean fill,
+	       GError **error)
+{
+  lua_State *L = buffered_thread (bs->klass);
+  const char *name = fill ? "do_fill" : "do_drain";
+  int top = lua_gettop (L);
+  gpointer buffer = NULL;
+  gboolean ok, owns_buffer = FALSE;
+
+  luaL_checkstack (L, 6, "");
+  lgi_object_2lua (L, stream, FALSE, FALSE);
+  lua_getfield (L, -1, name);
+  if (lua_isnil (L, -1))
+    {
+      lua_settop (L, top);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		   "%s not implemented", name);
+      return FALSE;
+    }
+  lua_insert (L, -2);
+  if (fill)
+    {
+      /* Keep the bytearray below the call, so that it stays alive
+	 while its contents are copied. */
+      buffered_push_buffer (L, bs->klass);
+      buffer = lua_touserdata (L, -1);
+      lua_insert (L, -3);
+      lua_pushvalue (L, -3);
+      owns_buffer = !bs->klass->buffer_busy;
+      bs->klass->buffer_busy = TRUE;
+    }
+  else
+    lua_pushlstring (L, (const char *) bs->data, bs->len);
+
+  ok = lua_pcall (L, 2, 2, 0) == 0;
+  if (owns_buffer)
+    bs->klass->buffer_busy = FALSE;
+  if (ok && lua_toboolean (L, -2))
+    {
+      if (fill && lua_type (L, -2) == LUA_TSTRING)
+	{
+	  /* Filled data can be returned also as a string. */
+	  size_t len;
+	  const char *data = lua_tolstring (L, -2, &len);
+	  bs->len = MIN (len, bs->klass->chunk_size);
+	  memcpy (bs->data, data, bs->len);
+	  if (len > bs->klass->chunk_size)
+	    g_warning ("%s: returned data do not fit into buffer", name);
+	}
+      else if (fill)
+	{
+	  bs->len = CLAMP (lua_tointeger (L, -2), 0,
+			   (lua_Integer) bs->klass->chunk_size);
+	  memcpy (bs->data, buffer, bs->len);
+	}
+      else
+	bs->len = 0;
+    }
+  else
+    {
+      /* Error is either thrown or returned as the second result, in
+	 both cases it is on the top of the stack; convert it to
+	 GError. */
+      GError *err = NULL;
+      lgi_type_get_repotype (L, G_TYPE_ERROR, NULL);
+      lgi_record_2c (L, -2, &err, FALSE, FALSE, TRUE, TRUE);
+      if (err != NULL)
+	g_propagate_error (error, g_error_copy (err));
+      else
+	g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s: %s", name,
+		     lua_isstring (L, -1) ? lua_tostring (L, -1) : "failed");
+      ok = FALSE;
+    }
+
+  lua_settop (L, top);
+  return ok;
+}
+
+static gssize
+buffered_read_fn (GInputStream *stream, void *buffer, gsize count,
+		  GCancellable *cancellable, GError **error)
+{
+  BufferedClass *klass = buffered_class_get (stream);
+  BufferedStream *bs;
+  gsize n;
+  (void) cancellable;
+
+  lgi_state_enter (klass->state_lock);
+  bs = buffered_stream_get (stream);
+  if (bs->pos == bs->len)
+    {
+      /* Buffer is exhausted, let Lua fill it again. */
+      bs->pos = bs->len = 0;
+      if (!buffered_call (bs, stream, TRUE, error))
+	{
+	  lgi_state_leave (klass->state_lock);
+	  return -1;
+	}
+    }
+
+  n = MIN (count, bs->len - bs->pos);
+  memcpy (buffer, bs->data + bs->pos, n);
+  bs->pos += n;
+  lgi_state_leave (klass->state_lock);
+  return n;
+}
+
+/* Drains buffered data of output stream, must be called inside the
+   state lock. */
+static gboolean
+buffered_drain (BufferedStream *bs, gpointer stream, GError **error)
+{
+  return bs->len == 0 || buffered_call (bs, stream, FALSE, error);
+}
+
+static gssize
+buffered_write_fn (GOutputStream *stream, const void *buffer, gsize count,
+		   GCancellable *cancellable, GError **error)
+{
+  BufferedClass *klass = buffered_class_get (stream);
+  BufferedStream *bs;
+  gsize n;
+  (void) cancellable;
+
+  lgi_state_enter (klass->state_lock);
+  bs = buffered_stream_get (stream);
+  if (bs->len == klass->chunk_size && !buffered_drain (bs, stream, error))
+    {
+      lgi_state_leave (klass->state_lock);
+      return -1;
+    }
+
+  n = MIN (count, klass->chunk_size - bs->len);
+  memcpy (bs->data + bs->len, buffer, n);
+  bs->len += n;
+  lgi_state_leave (klass->state_lock);
+  return n;
+}
+
+static gboolean
+buffered_flush (GOutputStream *stream, GCancellable *cancellable,
+		GError **error)
+{
+  BufferedClass *klass = buffered_class_get (stream);
+  gboolean ok;
+  (void) cancellable;
+
+  lgi_state_enter (klass->state_lock);
+  ok = buffered_drain (buffered_stream_get (stream), stream, error);
+  lgi_state_leave (klass->state_lock);
+  return ok;
+}
+
+static gboolean
+buffered_output_close_fn (GOutputStream *stream, GCancellable *cancellable,
+			  GError **error)
+{
+  /* Remaining data are drained during the close. */
+  return buffered_flush (stream, cancellable, error);
+}
+
+/* vfuncs = core.gio.buffered(gtype, 'input'|'output', chunk_size) */
+static int
+gio_buffered (lua_State *L)
+{
+  static const char *const kinds[] = { "input", "output", NULL };
+  GType gtype = lgi_type_get_gtype (L, 1);
+  int kind = luaL_checkoption (L, 2, NULL, kinds);
+  lua_Integer chunk_size = luaL_optinteger (L, 3, 64 * 1024);
+  BufferedClass *klass;
+
+  luaL_argcheck (L, chunk_size > 0, 3, "bad chunk size");
+  luaL_argcheck (L, g_type_is_a (gtype, kind == 0 ? G_TYPE_INPUT_STREAM
+				 : G_TYPE_OUTPUT_STREAM), 1,
+		 "stream type expected");
+  luaL_argcheck (L, g_type_get_qdata (gtype, buffered_quark) == NULL, 1,
+		 "type is already buffered");
+
+  /* Class data live as long as the type itself, i.e. forever. */
+  klass = g_new0 (BufferedClass, 1);
+  klass->chunk_size = chunk_size;
+  klass->state_lock = lgi_state_get_lock (L);
+  klass->L = lua_newthread (L);
+  klass->thread_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+  klass->buffer_ref = LUA_NOREF;
+  g_type_set_qdata (gtype, buffered_quark, klass);
+
+  /* Return addresses of vfuncs to be installed by the class. */
+  lua_newtable (L);
+  if (kind == 0)
+    {
+      lua_pushlightuserdata (L, buffered_read_fn);
+      lua_setfield (L, -2, "read_fn");
+    }
+  else
+    {
+      lua_pushlightuserdata (L, buffered_write_fn);
+      lua_setfield (L, -2, "write_fn");
+      lua_pushlightuserdata (L, buffered_flush);
+      lua_setfield (L, -2, "flush");
+      lua_pushlightuserdata (L, buffered_output_close_fn);
+      lua_setfield (L, -2, "close_fn");
+    }
+  return 1;
+}
+
+/* Native part of Gio.ValueListModel instances.  Lua data of the
+   model (table of values, function wrapping values into items and the
+   thread used for calling it) are anchored in the model's 'priv'
+   table, so that they are released together with the object. */
+typedef struct _ValueList
+{
+  /* Thread used for calling Lua, anchored in 'priv', and the state
+     lock. */
+  lua_State *L;
+  gpointer state_lock;
+
+  guint n_items;
+  GType item_type;
+
+  /* LRU cache of wrapped items, mapping position to link in the
+     queue, most recently used items are at the head. */
+  GHashTable *cache;
+  GQueue lru;
+  guint cache_size;
+} ValueList;
+
+/* Single cached item. */
+typedef struct _ValueListCached
+{
+  guint position;
+  GObject *item;
+} ValueListCached;
+
+static GQuark value_list_quark;
+
+/* lightuserdata keys of Lua data in the model's 'priv' table. */
+static int value_list_values, value_list_wrap, value_list_thread;
+
+static void
+value_list_uncache (ValueList *vl, GList *link)
+{
+  ValueListCached *cached = link->data;
+  g_hash_table_remove (vl->cache, GUINT_TO_POINTER (cached->position));
+  g_queue_delete_link (&vl->lru, link);
+  g_object_unref (cached->item);
+  g_free (cached);
+}
+
+/* Drops cached items at positions starting from 'position'. */
+static void
+value_list_invalidate (ValueList *vl, guint position)
+{
+  GList *link, *next;
+  for (link = vl->lru.head; link != NULL; link = next)
+    {
+      next = link->next;
+      if (((ValueListCached *) link->data)->position >= position)
+	value_list_uncache (vl, link);
+    }
+}
+
+static void
+value_list_free (gpointer data)
+{
+  ValueList *vl = data;
+  value_list_invalidate (vl, 0);
+  g_hash_table_destroy (vl->cache);
+  g_free (vl);
+}
+
+/* Pushes 'priv' table of the model. */
+static void
+value_list_push_priv (lua_State *L, gpointer list)
+{
+  lgi_object_2lua (L, list, FALSE, FALSE);
+  lua_getfield (L, -1, "priv");
+  lua_replace (L, -2);
+}
+
+/* Pushes value stored under lightuserdata key in 'priv' table at
+   index narg. */
+static void
+value_list_priv_get (lua_State *L, int narg, gpointer key)
+{
+  lua_pushlightuserdata (L, key);
+  lua_rawget (L, narg);
+}
+
+static GType
+value_list_get_item_type (gpointer list)
+{
+  ValueList *vl = g_object_get_qdata (list, value_list_quark);
+  return vl != NULL ? vl->item_type : G_TYPE_OBJECT;
+}
+
+static guint
+value_list_get_n_items (gpointer list)
+{
+  ValueList *vl = g_object_get_qdata (list, value_list_quark);
+  return vl != NULL ? vl->n_items : 0;
+}
+
+static gpointer
+value_list_get_item (gpointer list, guint position)
+{
+  ValueList *vl = g_object_get_qdata (list, value_list_quark);
+  GObject *item = NULL;
+  GList *link;
+  lua_State *L;
+  int top;
+
+  if (vl == NULL || position >= vl->n_items)
+    return NULL;
+
+  lgi_state_enter (vl->state_lock);
+  link = g_hash_table_lookup (vl->cache, GUINT_TO_POINTER (position));
+  if (link != NULL)
+    {
+      /* Cache hit, move the item to the head of LRU. */
+      g_queue_unlink (&vl->lru, link);
+      g_queue_push_head_link (&vl->lru, link);
+      item = g_object_ref (((ValueListCached *) link->data)->item);
+      lgi_state_leave (vl->state_lock);
+      return item;
+    }
+
+  /* Wrap the value by calling wrap(value, position). */
+  L = vl->L;
+  if (lua_status (L) != 0)
+    {
+      /* Thread is suspended, replace it with new one. */
+      L = lua_newthread (vl->L);
+      lua_xmove (vl->L, L, 1);
+      value_list_push_priv (L, list);
+      lua_pushlightuserdata (L, &value_list_thread);
+      lua_pushvalue (L, -3);
+      lua_rawset (L, -3);
+      lua_pop (L, 2);
+      vl->L = L;
+    }
+  top = lua_gettop (L);
+  luaL_checkstack (L, 5, "");
+  value_list_push_priv (L, list);
+  value_list_priv_get (L, top + 1, &value_list_wrap);
+  value_list_priv_get (L, top + 1, &value_list_values);
+  lua_rawgeti (L, -1, position + 1);
+  lua_replace (L, -2);
+  lua_pushnumber (L, position);
+  if (lua_pcall (L, 2, 1, 0) != 0)
+    g_warning ("Error raised while wrapping list item %u: %s", position,
+	       lua_tostring (L, -1));
+  else
+    {
+      item = lgi_object_2c (L, -1, G_TYPE_OBJECT, TRUE, TRUE, FALSE);
+      if (item == NULL || !g_type_is_a (G_OBJECT_TYPE (item), vl->item_type))
+	{
+	  g_warning ("Wrapped list item %u is not %s", position,
+		     g_type_name (vl->item_type));
+	  item = NULL;
+	}
+      else
+	{
+	  /* Store new item into the cache, one reference is owned by
+	     the cache and one returned to the caller. */
+	  ValueListCached *cached = g_new (ValueListCached, 1);
+	  cached->position = position;
+	  cached->item = g_object_ref (g_object_ref (item));
+	  g_queue_push_head (&vl->lru, cached);
+	  g_hash_table_insert (vl->cache, GUINT_TO_POINTER (position),
+			       vl->lru.head);
+	  if (vl->lru.length > vl->cache_size)
+	    value_list_uncache (vl, vl->lru.tail);
+	}
+    }
+  lua_settop (L, top);
+  lgi_state_leave (vl->state_lock);
+  return item;
+}
+
+/* Retrieves native part of the model at narg. */
+static ValueList *
+value_list_check (lua_State *L, int narg)
+{
+  gpointer list = lgi_object_2c (L, narg, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  ValueList *vl = g_object_get_qdata (list, value_list_quark);
+  luaL_argcheck (L, vl != NULL, narg, "Gio.ValueListModel expected");
+  return vl;
+}
+
+/* core.gio.value_list_init(model, values, wrap, item_gtype, cache_size) */
+static int
+gio_value_list_init (lua_State *L)
+{
+  gpointer list = lgi_object_2c (L, 1, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  GType item_type = lgi_type_get_gtype (L, 4);
+  lua_Integer cache_size = luaL_optinteger (L, 5, 256);
+  ValueList *vl;
+  guint i;
+
+  luaL_argcheck (L, cache_size >= 0, 5, "bad cache size");
+  luaL_checktype (L, 2, LUA_TTABLE);
+  luaL_checktype (L, 3, LUA_TFUNCTION);
+  luaL_argcheck (L, g_object_get_qdata (list, value_list_quark) == NULL, 1,
+		 "model is already initialized");
+
+  vl = g_new0 (ValueList, 1);
+  vl->state_lock = lgi_state_get_lock (L);
+  vl->item_type = item_type != G_TYPE_INVALID ? item_type : G_TYPE_OBJECT;
+  vl->cache_size = cache_size;
+  vl->cache = g_hash_table_new (NULL, NULL);
+  g_queue_init (&vl->lru);
+
+  /* Copy the values, so that the caller can reuse its table. */
+  vl->n_items = lua_objlen (L, 2);
+  lua_getfield (L, 1, "priv");
+  lua_pushlightuserdata (L, &value_list_values);
+  lua_createtable (L, vl->n_items, 0);
+  for (i = 1; i <= vl->n_items; i++)
+    {
+      lua_rawgeti (L, 2, i);
+      lua_rawseti (L, -2, i);
+    }
+  lua_rawset (L, -3);
+  lua_pushlightuserdata (L, &value_list_wrap);
+  lua_pushvalue (L, 3);
+  lua_rawset (L, -3);
+  lua_pushlightuserdata (L, &value_list_thread);
+  vl->L = lua_newthread (L);
+  lua_rawset (L, -3);
+  lua_pop (L, 1);
+  g_object_set_qdata_full (list, value_list_quark, vl, value_list_free);
+  return 0;
+}
+
+/* core.gio.value_list_splice(model, position, n_removals, values) */
+static int
+gio_value_list_splice (lua_State *L)
+{
+  ValueList *vl = value_list_check (L, 1);
+  gpointer list = lgi_object_2c (L, 1, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  lua_Integer position = luaL_checkinteger (L, 2);
+  lua_Integer n_removals = luaL_checkinteger (L, 3);
+  lua_Integer n_added, i, n = vl->n_items, delta;
+
+  luaL_argcheck (L, position >= 0 && position <= n, 2, "bad position");
+  luaL_argcheck (L, n_removals >= 0 && position + n_removals <= n, 3,
+		 "bad number of removals");
+  luaL_checktype (L, 4, LUA_TTABLE);
+  n_added = lua_objlen (L, 4);
+  delta = n_added - n_removals;
+
+  /* Shift tail of the values, then store added values. */
+  lua_getfield (L, 1, "priv");
+  value_list_priv_get (L, lua_gettop (L), &value_list_values);
+  lua_replace (L, -2);
+  if (delta > 0)
+    for (i = n; i > position + n_removals; i--)
+      {
+	lua_rawgeti (L, -1, i);
+	lua_rawseti (L, -2, i + delta);
+      }
+  else if (delta < 0)
+    {
+      for (i = position + n_removals + 1; i <= n; i++)
+	{
+	  lua_rawgeti (L, -1, i);
+	  lua_rawseti (L, -2, i + delta);
+	}
+      for (i = n + delta + 1; i <= n; i++)
+	{
+	  lua_pushnil (L);
+	  lua_rawseti (L, -2, i);
+	}
+    }
+  for (i = 1; i <= n_added; i++)
+    {
+      lua_rawgeti (L, 4, i);
+      lua_rawseti (L, -2, position + i);
+    }
+  lua_pop (L, 1);
+  vl->n_items = n + delta;
+
+  /* Cached items of changed positions are stale now. */
+  if (delta == 0)
+    {
+      GList *link, *next;
+      for (link = vl->lru.head; link != NULL; link = next)
+	{
+	  guint pos = ((ValueListCached *) link->data)->position;
+	  next = link->next;
+	  if (pos >= position && pos < position + n_added)
+	    value_list_uncache (vl, link);
+	}
+    }
+  else
+    value_list_invalidate (vl, position);
+
+  /* Whole change is signalled at once. */
+  if (n_removals > 0 || n_added > 0)
+    g_list_model_items_changed (list, position, n_removals, n_added);
+  return 0;
+}
+
+/* value = core.gio.value_list_get(model, position) */
+static int
+gio_value_list_get (lua_State *L)
+{
+  ValueList *vl = value_list_check (L, 1);
+  lua_Integer position = luaL_checkinteger (L, 2);
+  if (position < 0 || position >= vl->n_items)
+    return 0;
+  lua_getfield (L, 1, "priv");
+  value_list_priv_get (L, lua_gettop (L), &value_list_values);
+  lua_rawgeti (L, -1, position + 1);
+  return 1;
+}
+
+/* vfuncs = core.gio.value_list_vfuncs() */
+static int
+gio_value_list_vfuncs (lua_State *L)
+{
+  lua_newtable (L);
+  lua_pushlightuserdata (L, value_list_get_item_type);
+  lua_setfield (L, -2, "get_item_type");
+  lua_pushlightuserdata (L, value_list_get_n_items);
+  lua_setfield (L, -2, "get_n_items");
+  lua_pushlightuserdata (L, value_list_get_item);
+  lua_setfield (L, -2, "get_item");
+  return 1;
+}
+
+static const luaL_Reg gio_reg[] = {
+  { "next_batch", gio_next_batch },
+  { "next_batch_finish", gio_next_batch_finish },
+  { "buffered", gio_buffered },
+  { "value_list_init", gio_value_list_init },
+  { "value_list_splice", gio_value_list_splice },
+  { "value_list_get", gio_value_list_get },
+  { "value_list_vfuncs", gio_value_list_vfuncs },
+  { NULL, NULL }
+};
+
+void
+lgi_gio_init (lua_State *L)
+{
+  buffered_quark = g_quark_from_static_string ("lgi-buffered-stream");
+  value_list_quark = g_quark_from_static_string ("lgi-value-list");
+
+  /* Register gio API. */
+  lua_newtable (L);
+  luaL_register (L, NULL, gio_reg);
+  lua_setfield (L, -2, "gio");
+}
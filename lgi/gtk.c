@@ -0,0 +1,604 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native helpers for Gtk overrides.  Gtk is not linked in, all
+ * entry points are resolved by the override and passed in a table of
+ * symbols.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+/* Gtk.TextBuffer entry points. */
+typedef struct _TextBufferApi
+{
+  void (*get_iter_at_offset) (gpointer buffer, gpointer iter, gint offset);
+  void (*get_end_iter) (gpointer buffer, gpointer iter);
+  gpointer (*get_tag_table) (gpointer buffer);
+  void (*insert) (gpointer buffer, gpointer iter, const gchar *text, gint len);
+  void (*apply_tag) (gpointer buffer, gpointer tag, gconstpointer start,
+		     gconstpointer end);
+  gint (*iter_get_offset) (gconstpointer iter);
+  gpointer (*tag_table_lookup) (gpointer table, const gchar *name);
+
+  /* Size of GtkTextIter. */
+  size_t iter_size;
+} TextBufferApi;
+
+/* Loads text buffer api from the table of symbols at narg. */
+static void
+text_buffer_api_load (lua_State *L, int narg, TextBufferApi *api)
+{
+  luaL_checktype (L, narg, LUA_TTABLE);
+  api->get_iter_at_offset = lgi_gi_load_function (L, narg,
+						  "get_iter_at_offset");
+  api->get_end_iter = lgi_gi_load_function (L, narg, "get_end_iter");
+  api->get_tag_table = lgi_gi_load_function (L, narg, "get_tag_table");
+  api->insert = lgi_gi_load_function (L, narg, "insert");
+  api->apply_tag = lgi_gi_load_function (L, narg, "apply_tag");
+  api->iter_get_offset = lgi_gi_load_function (L, narg, "iter_get_offset");
+  api->tag_table_lookup = lgi_gi_load_function (L, narg, "tag_table_lookup");
+  lua_getfield (L, narg, "iter_size");
+  api->iter_size = lua_tointeger (L, -1);
+  lua_pop (L, 1);
+
+  if (api->get_iter_at_offset == NULL || api->get_end_iter == NULL
+      || api->get_tag_table == NULL || api->insert == NULL
+      || api->apply_tag == NULL || api->iter_get_offset == NULL
+      || api->tag_table_lookup == NULL || api->iter_size == 0)
+    luaL_error (L, "Gtk.TextBuffer symbols are not available");
+}
+
+/* Retrieves tag from narg, which is either tag instance or name of the
+   tag in the tag table of the buffer. */
+static gpointer
+text_buffer_get_tag (lua_State *L, TextBufferApi *api, gpointer buffer,
+		     int narg)
+{
+  if (lua_type (L, narg) == LUA_TSTRING)
+    {
+      const char *name = lua_tostring (L, narg);
+      gpointer tag = api->tag_table_lookup (api->get_tag_table (buffer), name);
+      if (tag == NULL)
+	luaL_error (L, "Gtk.TextBuffer: unknown tag '%s'", name);
+      return tag;
+    }
+
+  return lgi_object_2c (L, narg, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+}
+
+/* Applies tag between given character offsets. */
+static void
+text_buffer_apply (TextBufferApi *api, gpointer buffer, gpointer tag,
+		   gpointer start, gpointer end, gint start_offset,
+		   gint end_offset)
+{
+  /* Applying a tag invalidates all iterators, so they have to be
+     refetched for each application. */
+  api->get_iter_at_offset (buffer, start, start_offset);
+  api->get_iter_at_offset (buffer, end, end_offset);
+  api->apply_tag (buffer, tag, start, end);
+}
+
+/* Checks that run at the top of the stack has text and valid tags. */
+static void
+text_buffer_check_run (lua_State *L, TextBufferApi *api, gpointer buffer,
+		       int i)
+{
+  int j, n_tags;
+
+  /* Plain string is a run without tags. */
+  if (lua_type (L, -1) == LUA_TSTRING)
+    return;
+  if (!lua_istable (L, -1))
+    luaL_error (L, "Gtk.TextBuffer: run %d is not a table", i);
+  lua_rawgeti (L, -1, 1);
+  if (lua_type (L, -1) != LUA_TSTRING)
+    luaL_error (L, "Gtk.TextBuffer: run %d has no text", i);
+  lua_pop (L, 1);
+  n_tags = lua_objlen (L, -1) - 1;
+  for (j = 2; j <= n_tags + 1; j++)
+    {
+      lua_rawgeti (L, -1, j);
+      text_buffer_get_tag (L, api, buffer, -1);
+      lua_pop (L, 1);
+    }
+}
+
+/* end_offset = core.gtk.insert_runs(api, buffer, runs[, offset]) */
+static int
+gtk_insert_runs (lua_State *L)
+{
+  TextBufferApi api;
+  gpointer buffer, start, end;
+  gint offset, next;
+  int i, j, n, n_tags;
+
+  text_buffer_api_load (L, 1, &api);
+  buffer = lgi_object_2c (L, 2, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  luaL_checktype (L, 3, LUA_TTABLE);
+
+  /* Validate all runs and their tags first, so that invalid run does
+     not leave the buffer partially modified. */
+  for (n = 0; ; n++)
+    {
+      lua_rawgeti (L, 3, n + 1);
+      if (lua_isnil (L, -1))
+	{
+	  lua_pop (L, 1);
+	  break;
+	}
+      text_buffer_check_run (L, &api, buffer, n + 1);
+      lua_pop (L, 1);
+    }
+
+  /* Keep iterators in userdata, so that they are released even when
+     an error is thrown. */
+  start = lua_newuserdata (L, 2 * api.iter_size);
+  end = (char *) start + api.iter_size;
+  if (lua_isnoneornil (L, 4))
+    api.get_end_iter (buffer, end);
+  else
+    api.get_iter_at_offset (buffer, end, luaL_checkint (L, 4));
+  offset = api.iter_get_offset (end);
+
+  for (i = 1; i <= n; i++)
+    {
+      const char *text;
+      size_t len;
+
+      /* Text stays on the stack while it is inserted. */
+      lua_rawgeti (L, 3, i);
+      n_tags = 0;
+      if (lua_type (L, -1) == LUA_TSTRING)
+	lua_pushvalue (L, -1);
+      else
+	{
+	  n_tags = lua_objlen (L, -1) - 1;
+	  lua_rawgeti (L, -1, 1);
+	}
+      text = lua_tolstring (L, -1, &len);
+
+      api.insert (buffer, end, text, len);
+      next = api.iter_get_offset (end);
+      lua_pop (L, 1);
+      for (j = 2; j <= n_tags + 1; j++)
+	{
+	  lua_rawgeti (L, -1, j);
+	  text_buffer_apply (&api, buffer,
+			     text_buffer_get_tag (L, &api, buffer, -1),
+			     start, end, offset, next);
+	  lua_pop (L, 1);
+	}
+      if (n_tags > 0)
+	api.get_iter_at_offset (buffer, end, next);
+
+      offset = next;
+      lua_pop (L, 1);
+    }
+
+  lua_pushinteger (L, offset);
+  return 1;
+}
+
+/* core.gtk.apply_tag_ranges(api, buffer, tag, { start1, end1, ... }) */
+static int
+gtk_apply_tag_ranges (lua_State *L)
+{
+  TextBufferApi api;
+  gpointer buffer, tag, start, end;
+  int i, n;
+
+  text_buffer_api_load (L, 1, &api);
+  buffer = lgi_object_2c (L, 2, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  tag = text_buffer_get_tag (L, &api, buffer, 3);
+  luaL_checktype (L, 4, LUA_TTABLE);
+  n = lua_objlen (L, 4);
+  luaL_argcheck (L, n % 2 == 0, 4, "pairs of offsets expected");
+
+  start = lua_newuserdata (L, 2 * api.iter_size);
+  end = (char *) start + api.iter_size;
+  for (i = 1; i < n; i += 2)
+    {
+      gint start_offset, end_offset;
+      lua_rawgeti (L, 4, i);
+      lua_rawgeti (L, 4, i + 1);
+      start_offset = lua_tointeger (L, -2);
+      end_offset = lua_tointeger (L, -1);
+      lua_pop (L, 2);
+      text_buffer_apply (&api, buffer, tag, start, end,
+			 start_offset, end_offset);
+    }
+
+  return 0;
+}
+
+/* Gtk.CellLayout and Gtk.TreeModel entry points. */
+typedef struct _CellLayoutApi
+{
+  void (*set_cell_data_func) (gpointer layout, gpointer cell,
+			      gpointer func, gpointer data,
+			      GDestroyNotify destroy);
+  void (*get_value) (gpointer model, gpointer iter, gint column,
+		     GValue *value);
+} CellLayoutApi;
+
+/* Single entry of the attribute map. */
+typedef struct _CellMapEntry
+{
+  enum { CELL_KEY_NUMBER, CELL_KEY_STRING, CELL_KEY_BOOLEAN } kind;
+  gdouble number;
+  gchar *string;
+  GValue value;
+} CellMapEntry;
+
+/* Mapping of single model column to renderer property. */
+typedef struct _CellAttr
+{
+  gchar *property;
+  gint column;
+
+  /* Either printf-like format with single numeric conversion ... */
+  gchar *format;
+  gboolean format_integer;
+
+  /* ... or map of model values to property values, with optional
+     value used for unmapped keys. */
+  CellMapEntry *entries;
+  gint n_entries;
+  GValue fallback;
+} CellAttr;
+
+/* Set of mappings installed as cell data function. */
+typedef struct _CellMapping
+{
+  CellLayoutApi api;
+  CellAttr *attrs;
+  gint n_attrs;
+} CellMapping;
+
+/* Finds value mapped to the model value, NULL if there is none. */
+static const GValue *
+cell_attr_lookup (CellAttr *attr, const GValue *value)
+{
+  gint i;
+  gdouble number = 0;
+  gboolean is_number = lgi_value_number (value, &number);
+  gboolean is_boolean = G_VALUE_HOLDS_BOOLEAN (value);
+  const gchar *string = G_VALUE_HOLDS_STRING (value)
+    ? g_value_get_string (value) : NULL;
+
+  for (i = 0; i < attr->n_entries; i++)
+    {
+      CellMapEntry *entry = &attr->entries[i];
+      if ((entry->kind == CELL_KEY_NUMBER && is_number
+	   && entry->number == number)
+	  || (entry->kind == CELL_KEY_BOOLEAN && is_boolean
+	      && (entry->number != 0) == (g_value_get_boolean (value) != 0))
+	  || (entry->kind == CELL_KEY_STRING && string != NULL
+	      && strcmp (entry->string, string) == 0)
+	  || (entry->kind == CELL_KEY_STRING && G_VALUE_HOLDS_ENUM (value)
+	      && lgi_enum_matches (value, entry->string)))
+	return &entry->value;
+    }
+
+  return G_IS_VALUE (&attr->fallback) ? &attr->fallback : NULL;
+}
+
+/* Resets the property of the renderer to its default value.
+   Renderers are shared by all rows, so a row without mapped value
+   would show the value of the previously rendered one otherwise. */
+static void
+cell_reset_property (gpointer cell, const gchar *property)
+{
+  GParamSpec *pspec =
+    g_object_class_find_property (G_OBJECT_GET_CLASS (cell), property);
+  if (pspec != NULL)
+    {
+      GValue value = { 0 };
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+      g_param_value_set_default (pspec, &value);
+      g_object_set_property (cell, property, &value);
+      g_value_unset (&value);
+    }
+}
+
+static void
+cell_data_func (gpointer layout, gpointer cell, gpointer model,
+		gpointer iter, gpointer data)
+{
+  CellMapping *mapping = data;
+  gint i;
+  (void) layout;
+
+  for (i = 0; i < mapping->n_attrs; i++)
+    {
+      CellAttr *attr = &mapping->attrs[i];
+      GValue value = { 0 };
+      mapping->api.get_value (model, iter, attr->column, &value);
+      if (attr->format != NULL)
+	{
+	  gdouble number;
+	  if (lgi_value_number (&value, &number))
+	    {
+	      GValue text = { 0 };
+	      g_value_init (&text, G_TYPE_STRING);
+	      g_value_take_string (&text, attr->format_integer
+				   ? g_strdup_printf (attr->format,
+						      (gint64) number)
+				   : g_strdup_printf (attr->format, number));
+	      g_object_set_property (cell, attr->property, &text);
+	      g_value_unset (&text);
+	    }
+	  else
+	    cell_reset_property (cell, attr->property);
+	}
+      else
+	{
+	  const GValue *mapped = cell_attr_lookup (attr, &value);
+	  if (mapped != NULL)
+	    g_object_set_property (cell, attr->property, mapped);
+	  else
+	    cell_reset_property (cell, attr->property);
+	}
+      if (G_IS_VALUE (&value))
+	g_value_unset (&value);
+    }
+}
+
+static void
+cell_mapping_free (gpointer data)
+{
+  CellMapping *mapping = data;
+  gint i, j;
+  for (i = 0; i < mapping->n_attrs; i++)
+    {
+      CellAttr *attr = &mapping->attrs[i];
+      for (j = 0; j < attr->n_entries; j++)
+	{
+	  g_free (attr->entries[j].string);
+	  if (G_IS_VALUE (&attr->entries[j].value))
+	    g_value_unset (&attr->entries[j].value);
+	}
+      if (G_IS_VALUE (&attr->fallback))
+	g_value_unset (&attr->fallback);
+      g_free (attr->entries);
+      g_free (attr->format);
+      g_free (attr->property);
+    }
+  g_free (mapping->attrs);
+  g_free (mapping);
+}
+
+/* Copies GValue record at narg into uninitialized target. */
+static void
+cell_value_copy (lua_State *L, int narg, GValue *target)
+{
+  GValue *source;
+  lgi_type_get_repotype (L, G_TYPE_VALUE, NULL);
+  lgi_record_2c (L, narg, &source, FALSE, FALSE, FALSE, FALSE);
+  g_value_init (target, G_VALUE_TYPE (source));
+  g_value_copy (source, target);
+}
+
+/* Fills attribute from its definition table on the top of the stack
+   { property, column, format = string, map = { key, value, ... },
+   default = value }. */
+static void
+cell_attr_load (lua_State *L, CellAttr *attr)
+{
+  int i, n;
+
+  lua_rawgeti (L, -1, 1);
+  attr->property = g_strdup (luaL_checkstring (L, -1));
+  lua_rawgeti (L, -2, 2);
+  attr->column = luaL_checkint (L, -1);
+  lua_pop (L, 2);
+
+  lua_getfield (L, -1, "format");
+  if (!lua_isnil (L, -1))
+    {
+      attr->format = lgi_format_parse (luaL_checkstring (L, -1),
+					&attr->format_integer);
+      if (attr->format == NULL)
+	luaL_error (L, "`%s': bad format '%s'", attr->property,
+		    lua_tostring (L, -1));
+    }
+  lua_pop (L, 1);
+
+  lua_getfield (L, -1, "map");
+  if (!lua_isnil (L, -1))
+    {
+      luaL_checktype (L, -1, LUA_TTABLE);
+      n = lua_objlen (L, -1) / 2;
+      attr->entries = g_new0 (CellMapEntry, n);
+      for (i = 0; i < n; i++)
+	{
+	  CellMapEntry *entry = &attr->entries[i];
+	  lua_rawgeti (L, -1, 2 * i + 1);
+	  switch (lua_type (L, -1))
+	    {
+	    case LUA_TNUMBER:
+	      entry->kind = CELL_KEY_NUMBER;
+	      entry->number = lua_tonumber (L, -1);
+	      break;
+
+	    case LUA_TBOOLEAN:
+	      entry->kind = CELL_KEY_BOOLEAN;
+	      entry->number = lua_toboolean (L, -1);
+	      break;
+
+	    case LUA_TSTRING:
+	      entry->kind = CELL_KEY_STRING;
+	      entry->string = g_strdup (lua_tostring (L, -1));
+	      break;
+
+	    default:
+	      luaL_error (L, "`%s': bad map key", attr->property);
+	    }
+
+	  /* Count the entry before copying its value, so that its key
+	     is released when the copy fails. */
+	  attr->n_entries++;
+	  lua_rawgeti (L, -2, 2 * i + 2);
+	  cell_value_copy (L, -1, &entry->value);
+	  lua_pop (L, 2);
+	}
+    }
+  lua_pop (L, 1);
+
+  lua_getfield (L, -1, "default");
+  if (!lua_isnil (L, -1))
+    cell_value_copy (L, -1, &attr->fallback);
+  lua_pop (L, 1);
+}
+
+/* core.gtk.map_attributes(api, layout, cell, attrs) */
+static int
+gtk_map_attributes (lua_State *L)
+{
+  CellMapping *mapping;
+  gpointer layout, cell, *guard;
+  int i;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  layout = lgi_object_2c (L, 2, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  cell = lgi_object_2c (L, 3, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  luaL_checktype (L, 4, LUA_TTABLE);
+
+  /* Guard the mapping until it is handed over to the layout. */
+  mapping = g_new0 (CellMapping, 1);
+  guard = lgi_guard_create (L, cell_mapping_free);
+  *guard = mapping;
+  mapping->api.set_cell_data_func =
+    lgi_gi_load_function (L, 1, "set_cell_data_func");
+  mapping->api.get_value = lgi_gi_load_function (L, 1, "get_value");
+  if (mapping->api.set_cell_data_func == NULL
+      || mapping->api.get_value == NULL)
+    return luaL_error (L, "Gtk.CellLayout symbols are not available");
+
+  mapping->attrs = g_new0 (CellAttr, lua_objlen (L, 4));
+  for (i = 1; i <= (int) lua_objlen (L, 4); i++)
+    {
+      lua_rawgeti (L, 4, i);
+      luaL_checktype (L, -1, LUA_TTABLE);
+      cell_attr_load (L, &mapping->attrs[mapping->n_attrs++]);
+      lua_pop (L, 1);
+    }
+
+  *guard = NULL;
+  mapping->api.set_cell_data_func (layout, cell, cell_data_func, mapping,
+				   cell_mapping_free);
+  return 0;
+}
+
+/* Gtk.ListStore or Gtk.TreeStore entry points used for sorting. */
+typedef struct _StoreSortApi
+{
+  gboolean (*iter_children) (gpointer model, gpointer iter, gpointer parent);
+  gboolean (*iter_next) (gpointer model, gpointer iter);
+  void (*get_value) (gpointer model, gpointer iter, gint column,
+		     GValue *value);
+
+  /* Either gtk_list_store_reorder or gtk_tree_store_reorder. */
+  void (*list_reorder) (gpointer store, gint *order);
+  void (*tree_reorder) (gpointer store, gpointer parent, gint *order);
+
+  /* Size of GtkTreeIter. */
+  size_t iter_size;
+} StoreSortApi;
+
+/* core.gtk.sort_store(api, store, column | keys, descending[, parent]) */
+static int
+gtk_sort_store (lua_State *L)
+{
+  StoreSortApi api;
+  gpointer store, parent = NULL, iter;
+  gint n = 0, *order;
+  gboolean valid;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  api.iter_children = lgi_gi_load_function (L, 1, "iter_children");
+  api.iter_next = lgi_gi_load_function (L, 1, "iter_next");
+  api.get_value = lgi_gi_load_function (L, 1, "get_value");
+  api.list_reorder = lgi_gi_load_function (L, 1, "list_reorder");
+  api.tree_reorder = lgi_gi_load_function (L, 1, "tree_reorder");
+  lua_getfield (L, 1, "iter_size");
+  api.iter_size = lua_tointeger (L, -1);
+  lua_pop (L, 1);
+  if (api.iter_children == NULL || api.iter_next == NULL
+      || api.get_value == NULL || api.iter_size == 0
+      || (api.list_reorder == NULL && api.tree_reorder == NULL))
+    return luaL_error (L, "Gtk store symbols are not available");
+
+  store = lgi_object_2c (L, 2, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+  if (api.tree_reorder != NULL)
+    {
+      lua_getfield (L, 1, "iter_type");
+      lgi_record_2c (L, 5, &parent, FALSE, FALSE, TRUE, FALSE);
+    }
+
+  /* Count the rows and, when sorting by column, extract the keys. */
+  iter = lua_newuserdata (L, api.iter_size);
+  if (lua_type (L, 3) == LUA_TNUMBER)
+    {
+      gint column = lua_tointeger (L, 3);
+      lua_newtable (L);
+      lua_replace (L, 3);
+      for (valid = api.iter_children (store, iter, parent); valid;
+	   valid = api.iter_next (store, iter))
+	{
+	  GValue value = { 0 };
+	  gdouble number;
+	  api.get_value (store, iter, column, &value);
+	  if (G_VALUE_HOLDS_STRING (&value))
+	    lua_pushstring (L, g_value_get_string (&value));
+	  else if (G_VALUE_HOLDS_BOOLEAN (&value))
+	    lua_pushnumber (L, g_value_get_boolean (&value));
+	  else if (lgi_value_number (&value, &number))
+	    lua_pushnumber (L, number);
+	  else
+	    lua_pushnil (L);
+	  lua_rawseti (L, 3, ++n);
+	  g_value_unset (&value);
+	}
+    }
+  else
+    {
+      luaL_checktype (L, 3, LUA_TTABLE);
+      for (valid = api.iter_children (store, iter, parent); valid;
+	   valid = api.iter_next (store, iter))
+	n++;
+    }
+
+  if (n > 1)
+    {
+      order = lgi_sort_order (L, 3, n, lua_toboolean (L, 4));
+      if (api.tree_reorder != NULL)
+	api.tree_reorder (store, parent, order);
+      else
+	api.list_reorder (store, order);
+      g_free (order);
+    }
+  return 0;
+}
+
+static const luaL_Reg gtk_reg[] = {
+  { "insert_runs", gtk_insert_runs },
+  { "apply_tag_ranges", gtk_apply_tag_ranges },
+  { "map_attributes", gtk_map_attributes },
+  { "sort_store", gtk_sort_store },
+  { NULL, NULL }
+};
+
+void
+lgi_gtk_init (lua_State *L)
+{
+  /* Register gtk API. */
+  lua_newtable (L);
+  luaL_register (L, NULL, gtk_reg);
+  lua_setfield (L, -2, "gtk");
+}
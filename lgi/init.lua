@@ -22,7 +22,8 @@ local core = require 'lgi.core'
 local lgi = { _NAME = 'lgi', _VERSION = require 'lgi.version' }
 
 -- Forward selected core methods into external interface.
-for _, name in pairs { 'yield', 'lock', 'enter', 'leave' } do
+for _, name in pairs { 'yield', 'lock', 'enter', 'leave',
+			  'schedule', 'schedule_policy', 'sort' } do
    lgi[name] = core[name]
 end
 
@@ -37,6 +38,10 @@ end
 -- functionality related to logging wrapped around GLib g_log facility.
 lgi.log = require 'lgi.log'
 
+-- Event trace recorder and sampling profiler.
+lgi.trace = core.trace
+lgi.profile = core.profile
+
 -- For the rest of bootstrap, prepare logging to lgi domain.
 local log = lgi.log.domain('lgi')
 
@@ -83,6 +88,8 @@ repo.GLib._precondition = {}
 repo.GLib._precondition.Error = 'GLib-Error'
 repo.GLib._precondition.Bytes = 'GLib-Bytes'
 repo.GLib._precondition.Timer = 'GLib-Timer'
+repo.GLib._precondition.MappedFile = 'GLib-MappedFile'
+repo.GLib._precondition.MainContext = 'GLib-MainContext'
 repo.GLib._precondition.MarkupParser = 'GLib-Markup'
 repo.GLib._precondition.MarkupParseContext = 'GLib-Markup'
 repo.GLib._precondition.Source = 'GLib-Source'
@@ -35,6 +35,98 @@
 #include <girepository.h>
 #include <gmodule.h>
 
+/* Static tracepoints for external tracing tools (SystemTap, bpftrace,
+   perf), compiled in only when LGI_ENABLE_USDT is defined.  Every
+   probe has a semaphore which is nonzero only while some tool is
+   attached to it, so that probe arguments are not evaluated
+   otherwise.  Semaphores are defined in core.c. */
+#ifdef LGI_ENABLE_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define LGI_PROBE_SEMAPHORE(name) lgi_ ## name ## _semaphore
+#define LGI_PROBE_ENABLED(name) G_UNLIKELY (LGI_PROBE_SEMAPHORE (name) != 0)
+#define LGI_PROBE_DECLARE(name)						\
+  extern volatile unsigned short LGI_PROBE_SEMAPHORE (name)
+LGI_PROBE_DECLARE (call__entry);
+LGI_PROBE_DECLARE (call__return);
+LGI_PROBE_DECLARE (callback__entry);
+LGI_PROBE_DECLARE (callback__return);
+LGI_PROBE_DECLARE (state__enter);
+LGI_PROBE_DECLARE (object__2lua);
+LGI_PROBE_DECLARE (object__gc);
+LGI_PROBE_DECLARE (record__gc);
+#define LGI_PROBE1(name, a1)						\
+  do {									\
+    if (LGI_PROBE_ENABLED (name))					\
+      DTRACE_PROBE1 (lgi, name, a1);					\
+  } while (0)
+#define LGI_PROBE2(name, a1, a2)					\
+  do {									\
+    if (LGI_PROBE_ENABLED (name))					\
+      DTRACE_PROBE2 (lgi, name, a1, a2);				\
+  } while (0)
+#define LGI_PROBE3(name, a1, a2, a3)					\
+  do {									\
+    if (LGI_PROBE_ENABLED (name))					\
+      DTRACE_PROBE3 (lgi, name, a1, a2, a3);				\
+  } while (0)
+#else
+#define LGI_PROBE_ENABLED(name) FALSE
+#define LGI_PROBE1(name, a1) ((void) 0)
+#define LGI_PROBE2(name, a1, a2) ((void) 0)
+#define LGI_PROBE3(name, a1, a2, a3) ((void) 0)
+#endif
+
+/* Categories of events recorded by lgi.trace and the mask of
+   categories being currently recorded, 0 when tracing is off. */
+#define LGI_TRACE_CALLS 1
+#define LGI_TRACE_CALLBACKS 2
+#define LGI_TRACE_GC 4
+#define LGI_TRACE_MAINLOOP 8
+extern volatile gint lgi_trace_mask;
+
+/* Records begin ('B') or end ('E') event.  Strings must outlive the
+   recording; detail is optional. */
+void lgi_trace_event (gint category, gchar phase, const gchar *scope,
+		      const gchar *name, const gchar *detail);
+
+/* Returns interned 'source:line' location of the function at the top
+   of the stack. */
+const gchar *lgi_trace_location (lua_State *L);
+
+#define LGI_TRACE(category, phase, scope, name, detail)			\
+  do {									\
+    if (G_UNLIKELY (lgi_trace_mask & (category)))			\
+      lgi_trace_event (category, phase, scope, name, detail);		\
+  } while (0)
+
+/* Nonzero while lgi.profile sampling profiler runs. */
+extern volatile gint lgi_profile_active;
+
+/* Switches profiler attribution to native function 'name', or to Lua
+   code when name is NULL.  Previous state is saved in the frame and
+   restored by lgi_profile_leave. */
+typedef struct _LgiProfileFrame
+{
+  const gchar *scope, *name;
+  gboolean entered;
+} LgiProfileFrame;
+void lgi_profile_enter (lua_State *L, LgiProfileFrame *frame,
+			const gchar *scope, const gchar *name);
+void lgi_profile_leave (lua_State *L, LgiProfileFrame *frame);
+
+#define LGI_PROFILE_ENTER(L, frame, scope, name)			\
+  do {									\
+    (frame)->entered = FALSE;						\
+    if (G_UNLIKELY (lgi_profile_active))				\
+      lgi_profile_enter (L, frame, scope, name);			\
+  } while (0)
+#define LGI_PROFILE_LEAVE(L, frame)					\
+  do {									\
+    if (G_UNLIKELY ((frame)->entered))					\
+      lgi_profile_leave (L, frame);					\
+  } while (0)
+
 /* Makes sure that Lua stack offset is absolute one, not relative. */
 #define lgi_makeabs(L, x) do { if (x < 0) x += lua_gettop (L) + 1; } while (0)
 
@@ -67,6 +159,19 @@ void lgi_object_init (lua_State *L);
 void lgi_callable_init (lua_State *L);
 void lgi_gi_init (lua_State *L);
 void lgi_buffer_init (lua_State *L);
+void lgi_gio_init (lua_State *L);
+void lgi_gtk_init (lua_State *L);
+void lgi_poll_init (lua_State *L);
+void lgi_schedule_init (lua_State *L);
+void lgi_sort_init (lua_State *L);
+void lgi_variant_init (lua_State *L);
+void lgi_binding_init (lua_State *L);
+void lgi_cairo_init (lua_State *L);
+void lgi_trace_init (lua_State *L);
+void lgi_profile_init (lua_State *L);
+#ifdef LGI_EMBED_LUA
+void lgi_embed_init (lua_State *L);
+#endif
 
 /* Checks whether given argument is of specified udata - similar to
    luaL_testudata, which is missing in Lua 5.1 */
@@ -76,6 +181,7 @@ lgi_udata_test (lua_State *L, int narg, const char *name);
 /* Metatable name of userdata for 'bytes' extension; see
    http://permalink.gmane.org/gmane.comp.lang.lua.general/79288 */
 #define LGI_BYTES_BUFFER "bytes.bytearray"
+#define LGI_BYTES_VIEW "bytes.view"
 
 /* Metatable name of userdata - gi wrapped 'GIBaseInfo*' */
 #define LGI_GI_INFO "lgi.gi.info"
@@ -88,6 +194,24 @@ int lgi_gi_info_new (lua_State *L, GIBaseInfo *info);
    NULL if table does not contain such field. */
 gpointer lgi_gi_load_function(lua_State *L, int typetable, const char *name);
 
+/* Sorts 'n' keys stored in the array table at narg, which are either
+   all numbers or all strings (nils are sorted last).  Returns newly
+   allocated array of 0-based original positions in sorted order. */
+gint *lgi_sort_order (lua_State *L, int narg, gint n, gboolean descending);
+
+/* Retrieves numeric contents of the value, returns FALSE if the value
+   is not numeric. */
+gboolean lgi_value_number (const GValue *value, gdouble *number);
+
+/* Checks whether string key matches nick of the enum value, comparing
+   case-insensitively and treating '-' and '_' as equal. */
+gboolean lgi_enum_matches (const GValue *value, const gchar *key);
+
+/* Validates format containing exactly one numeric conversion and
+   returns its copy, with integer conversions adjusted to take
+   gint64.  Returns NULL if the format is not valid. */
+gchar *lgi_format_parse (const char *format, gboolean *integer);
+
 /* Retrieve synchronization state, which can be used for entering and
    leaving the state using lgi_state_enter() and lgi_state_leave(). */
 gpointer lgi_state_get_lock (lua_State *L);
@@ -968,19 +968,18 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 	    str = (gchar *) luaL_checkstring (L, narg);
 	}
 
-	if (tag == GI_TYPE_TAG_FILENAME)
+	if (tag == GI_TYPE_TAG_FILENAME && str != NULL
+	    && !g_get_filename_charsets (NULL))
 	  {
-	    /* Convert from UTF-8 to filename encoding. */
-	    if (str)
+	    /* Convert from UTF-8 to filename encoding, unless the
+	       filename encoding is UTF-8 too. */
+	    str = g_filename_from_utf8 (str, -1, NULL, NULL, NULL);
+	    if (transfer != GI_TRANSFER_EVERYTHING)
 	      {
-		str = g_filename_from_utf8 (str, -1, NULL, NULL, NULL);
-		if (transfer != GI_TRANSFER_EVERYTHING)
-		  {
-		    /* Create temporary object on the stack which will
-		       destroy the allocated temporary filename. */
-		    *lgi_guard_create (L, g_free) = (gpointer) str;
-		    nret = 1;
-		  }
+		/* Create temporary object on the stack which will
+		   destroy the allocated temporary filename. */
+		*lgi_guard_create (L, g_free) = (gpointer) str;
+		nret = 1;
 	      }
 	  }
 	else if (transfer == GI_TRANSFER_EVERYTHING)
@@ -1268,7 +1267,8 @@ lgi_marshal_2lua (lua_State *L, GITypeInfo *ti, GIArgInfo *ai, GIDirection dir,
       {
 	gchar *str = (parent == LGI_PARENT_FORCE_POINTER)
 	  ? arg->v_pointer : arg->v_string;
-	if (tag == GI_TYPE_TAG_FILENAME && str != NULL)
+	if (tag == GI_TYPE_TAG_FILENAME && str != NULL
+	    && !g_get_filename_charsets (NULL))
 	  {
 	    gchar *utf8 = g_filename_to_utf8 (str, -1, NULL, NULL, NULL);
 	    lua_pushstring (L, utf8);
@@ -85,6 +85,10 @@ function namespace.mt:__index(symbol)
       end
       preconditions[symbol] = nil
       if not next(preconditions) then self._precondition = nil end
+
+      -- Override can also define the symbol directly.
+      val = rawget(self, symbol)
+      if val ~= nil then return val end
    end
 
    -- Check, whether symbol is already loaded.
@@ -265,7 +265,17 @@ object_unref (lua_State *L, gpointer obj)
 static int
 object_gc (lua_State *L)
 {
-  object_unref (L, object_get (L, 1));
+  gpointer obj = object_get (L, 1);
+  const gchar *name = "object";
+
+  /* Type name is looked up only when somebody is listening. */
+  if (LGI_PROBE_ENABLED (object__gc)
+      || G_UNLIKELY (lgi_trace_mask & LGI_TRACE_GC))
+    name = g_type_name (G_TYPE_FROM_INSTANCE (obj));
+  LGI_PROBE2 (object__gc, obj, name);
+  LGI_TRACE (LGI_TRACE_GC, 'B', NULL, name, NULL);
+  object_unref (L, obj);
+  LGI_TRACE (LGI_TRACE_GC, 'E', NULL, name, NULL);
 
   /* Unset the metatable / make the object unusable */
   lua_pushnil (L);
@@ -340,6 +350,8 @@ lgi_object_2lua (lua_State *L, gpointer obj, gboolean own, gboolean no_sink)
     {
       /* Use the object from the cache. */
       lua_replace (L, -2);
+      LGI_PROBE3 (object__2lua, obj,
+		  g_type_name (G_TYPE_FROM_INSTANCE (obj)), 1);
 
       /* If the object was already owned, remove one reference,
 	 because our proxy always keeps only one reference, which we
@@ -350,6 +362,8 @@ lgi_object_2lua (lua_State *L, gpointer obj, gboolean own, gboolean no_sink)
     }
 
   /* Create new userdata object. */
+  LGI_PROBE3 (object__2lua, obj,
+	      g_type_name (G_TYPE_FROM_INSTANCE (obj)), 0);
   *(gpointer *) lua_newuserdata (L, sizeof (obj)) = obj;
   lua_pushlightuserdata (L, &object_mt);
   lua_rawget (L, LUA_REGISTRYINDEX);
@@ -578,12 +592,343 @@ object_new (lua_State *L)
     }
 }
 
+/* Finds property of given object, caches specification for
+   consecutive objects of the same class. */
+static GParamSpec *
+object_column_pspec (lua_State *L, GObject *obj, const gchar *name,
+		     GParamFlags flags, GType *gtype, GParamSpec *pspec)
+{
+  if (G_OBJECT_TYPE (obj) == *gtype)
+    return pspec;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (obj), name);
+  if (pspec == NULL)
+    luaL_error (L, "%s: no property `%s'", G_OBJECT_TYPE_NAME (obj), name);
+  if ((pspec->flags & flags) != flags)
+    luaL_error (L, "%s: `%s' not %s", G_OBJECT_TYPE_NAME (obj), name,
+		(flags & G_PARAM_READABLE) ? "readable" : "writable");
+  *gtype = G_OBJECT_TYPE (obj);
+  return pspec;
+}
+
+/* values = core.object.get_column(objects, name, unpack[, values])
+   Reads property of all objects.  Values of basic types are converted
+   natively, other values are passed as GObject.Value to unpack
+   function, which returns their Lua value. */
+static int
+object_get_column (lua_State *L)
+{
+  const gchar *name = luaL_checkstring (L, 2);
+  GParamSpec *pspec = NULL;
+  GType gtype = G_TYPE_INVALID;
+  int i, n;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  luaL_checktype (L, 3, LUA_TFUNCTION);
+  if (lua_isnoneornil (L, 4))
+    {
+      lua_settop (L, 3);
+      lua_createtable (L, lua_objlen (L, 1), 0);
+    }
+  else
+    {
+      luaL_checktype (L, 4, LUA_TTABLE);
+      lua_settop (L, 4);
+    }
+
+  n = lua_objlen (L, 1);
+  for (i = 1; i <= n; i++)
+    {
+      GObject *obj;
+      GValue value = { 0 };
+
+      lua_rawgeti (L, 1, i);
+      obj = lgi_object_2c (L, -1, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+      lua_pop (L, 1);
+      pspec = object_column_pspec (L, obj, name, G_PARAM_READABLE,
+				   &gtype, pspec);
+      g_value_init (&value, pspec->value_type);
+      g_object_get_property (obj, pspec->name, &value);
+      switch (G_TYPE_FUNDAMENTAL (pspec->value_type))
+	{
+	case G_TYPE_BOOLEAN:
+	  lua_pushboolean (L, g_value_get_boolean (&value));
+	  break;
+
+#define H(gtype, get)					\
+	  case gtype:					\
+	    lua_pushnumber (L, (lua_Number) get (&value));	\
+	    break;
+
+	  H(G_TYPE_CHAR, g_value_get_schar)
+	  H(G_TYPE_UCHAR, g_value_get_uchar)
+	  H(G_TYPE_INT, g_value_get_int)
+	  H(G_TYPE_UINT, g_value_get_uint)
+	  H(G_TYPE_LONG, g_value_get_long)
+	  H(G_TYPE_ULONG, g_value_get_ulong)
+	  H(G_TYPE_INT64, g_value_get_int64)
+	  H(G_TYPE_UINT64, g_value_get_uint64)
+	  H(G_TYPE_FLOAT, g_value_get_float)
+	  H(G_TYPE_DOUBLE, g_value_get_double)
+#undef H
+
+	case G_TYPE_STRING:
+	  lua_pushstring (L, g_value_get_string (&value));
+	  break;
+
+	case G_TYPE_OBJECT:
+	  lgi_object_2lua (L, g_value_get_object (&value), FALSE, FALSE);
+	  break;
+
+	default:
+	  {
+	    /* Let Lua-side marshaller handle the value. */
+	    GValue *target;
+	    lua_pushvalue (L, 3);
+	    lgi_type_get_repotype (L, G_TYPE_VALUE, NULL);
+	    target = lgi_record_new (L, 1, FALSE);
+	    g_value_init (target, pspec->value_type);
+	    g_value_copy (&value, target);
+	    lua_call (L, 1, 1);
+	    break;
+	  }
+	}
+      g_value_unset (&value);
+      lua_rawseti (L, 4, i);
+    }
+
+  return 1;
+}
+
+/* core.object.set_column(objects, name, pack, values)
+   Sets property of all objects, values is either array of values or
+   single non-table value used for all objects.  Values which cannot
+   be converted natively are converted by pack(gtype, value) function
+   returning GObject.Value. */
+static int
+object_set_column (lua_State *L)
+{
+  const gchar *name = luaL_checkstring (L, 2);
+  GParamSpec *pspec = NULL;
+  GType gtype = G_TYPE_INVALID;
+  gboolean single = lua_type (L, 4) != LUA_TTABLE;
+  int i, n;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  luaL_checktype (L, 3, LUA_TFUNCTION);
+  lua_settop (L, 4);
+
+  n = lua_objlen (L, 1);
+  for (i = 1; i <= n; i++)
+    {
+      GObject *obj;
+      GValue value = { 0 };
+
+      lua_rawgeti (L, 1, i);
+      obj = lgi_object_2c (L, -1, G_TYPE_OBJECT, FALSE, FALSE, FALSE);
+      pspec = object_column_pspec (L, obj, name, G_PARAM_WRITABLE,
+				   &gtype, pspec);
+      if (single)
+	lua_pushvalue (L, 4);
+      else
+	lua_rawgeti (L, 4, i);
+
+      g_value_init (&value, pspec->value_type);
+      switch (G_TYPE_FUNDAMENTAL (pspec->value_type))
+	{
+	case G_TYPE_BOOLEAN:
+	  g_value_set_boolean (&value, lua_toboolean (L, -1));
+	  break;
+
+#define H(gtype, set, ctype)					\
+	  case gtype:						\
+	    set (&value, (ctype) luaL_checknumber (L, -1));	\
+	    break;
+
+	  H(G_TYPE_CHAR, g_value_set_schar, gint8)
+	  H(G_TYPE_UCHAR, g_value_set_uchar, guchar)
+	  H(G_TYPE_INT, g_value_set_int, gint)
+	  H(G_TYPE_UINT, g_value_set_uint, guint)
+	  H(G_TYPE_LONG, g_value_set_long, glong)
+	  H(G_TYPE_ULONG, g_value_set_ulong, gulong)
+	  H(G_TYPE_INT64, g_value_set_int64, gint64)
+	  H(G_TYPE_UINT64, g_value_set_uint64, guint64)
+	  H(G_TYPE_FLOAT, g_value_set_float, gfloat)
+	  H(G_TYPE_DOUBLE, g_value_set_double, gdouble)
+#undef H
+
+	case G_TYPE_STRING:
+	  g_value_set_string (&value, lua_isnil (L, -1) ? NULL
+			      : luaL_checkstring (L, -1));
+	  break;
+
+	case G_TYPE_OBJECT:
+	  g_value_set_object (&value, lgi_object_2c (L, -1, pspec->value_type,
+						     TRUE, FALSE, FALSE));
+	  break;
+
+	default:
+	  {
+	    GValue *source;
+	    lua_pushvalue (L, 3);
+	    lua_pushstring (L, g_type_name (pspec->value_type));
+	    lua_pushvalue (L, -3);
+	    lua_call (L, 2, 1);
+	    lgi_type_get_repotype (L, G_TYPE_VALUE, NULL);
+	    lgi_record_2c (L, -2, &source, FALSE, FALSE, FALSE, FALSE);
+	    g_value_copy (source, &value);
+	    break;
+	  }
+	}
+
+      g_object_set_property (obj, pspec->name, &value);
+      g_value_unset (&value);
+      lua_settop (L, 4);
+    }
+
+  return 0;
+}
+
+/* Property table of Lua-derived class, stored as qdata of the
+   class GType. */
+typedef struct _PropertyClass
+{
+  /* Number of properties installed by the class and flags whether
+     the property is stored natively, indexed by prop_id - 1. */
+  guint n_props;
+  gboolean *native;
+
+  /* Quark of instance qdata holding native property values. */
+  GQuark slots_quark;
+
+  /* Lua-implemented accessors, used for non-native properties. */
+  GObjectGetPropertyFunc get_fallback;
+  GObjectSetPropertyFunc set_fallback;
+} PropertyClass;
+
+/* Native property values of single instance. */
+typedef struct _PropertySlots
+{
+  guint n_props;
+  GValue values[1];
+} PropertySlots;
+
+static GQuark property_class_quark;
+
+static void
+property_slots_free (gpointer data)
+{
+  PropertySlots *slots = data;
+  guint i;
+  for (i = 0; i < slots->n_props; i++)
+    if (G_IS_VALUE (&slots->values[i]))
+      g_value_unset (&slots->values[i]);
+  g_free (slots);
+}
+
+static void
+property_get (GObject *obj, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  PropertyClass *pc = g_type_get_qdata (pspec->owner_type,
+					property_class_quark);
+  PropertySlots *slots;
+  if (!pc->native[prop_id - 1])
+    {
+      pc->get_fallback (obj, prop_id, value, pspec);
+      return;
+    }
+
+  slots = g_object_get_qdata (obj, pc->slots_quark);
+  if (slots != NULL && G_IS_VALUE (&slots->values[prop_id - 1]))
+    g_value_copy (&slots->values[prop_id - 1], value);
+  else
+    g_param_value_set_default (pspec, value);
+}
+
+static void
+property_set (GObject *obj, guint prop_id, const GValue *value,
+	      GParamSpec *pspec)
+{
+  PropertyClass *pc = g_type_get_qdata (pspec->owner_type,
+					property_class_quark);
+  PropertySlots *slots;
+  GValue *slot;
+  if (!pc->native[prop_id - 1])
+    {
+      pc->set_fallback (obj, prop_id, value, pspec);
+      return;
+    }
+
+  slots = g_object_get_qdata (obj, pc->slots_quark);
+  if (slots == NULL)
+    {
+      slots = g_malloc0 (G_STRUCT_OFFSET (PropertySlots, values)
+			 + pc->n_props * sizeof (GValue));
+      slots->n_props = pc->n_props;
+      g_object_set_qdata_full (obj, pc->slots_quark, slots,
+			       property_slots_free);
+    }
+
+  slot = &slots->values[prop_id - 1];
+  if (G_IS_VALUE (slot))
+    g_value_unset (slot);
+  g_value_init (slot, G_VALUE_TYPE (value));
+  g_value_copy (value, slot);
+}
+
+/* get_property, set_property =
+     core.object.properties(gtype, native, get_fallback, set_fallback)
+   Registers property table of Lua-derived class.  'native' is array
+   of flags, indexed by prop_id, whether property value is kept in
+   native storage.  Accessors of other properties are forwarded to
+   fallback callbacks.  Returns addresses of accessors to be installed
+   into the class structure. */
+static int
+object_properties (lua_State *L)
+{
+  GType gtype = lgi_type_get_gtype (L, 1);
+  PropertyClass *pc;
+  gchar *name;
+  guint i;
+
+  luaL_argcheck (L, G_TYPE_IS_OBJECT (gtype), 1, "object type expected");
+  luaL_checktype (L, 2, LUA_TTABLE);
+  luaL_checktype (L, 3, LUA_TLIGHTUSERDATA);
+  luaL_checktype (L, 4, LUA_TLIGHTUSERDATA);
+  luaL_argcheck (L, g_type_get_qdata (gtype, property_class_quark) == NULL,
+		 1, "properties are already registered");
+
+  pc = g_new (PropertyClass, 1);
+  pc->n_props = lua_objlen (L, 2);
+  pc->native = g_new (gboolean, pc->n_props);
+  for (i = 0; i < pc->n_props; i++)
+    {
+      lua_rawgeti (L, 2, i + 1);
+      pc->native[i] = lua_toboolean (L, -1);
+      lua_pop (L, 1);
+    }
+
+  name = g_strdup_printf ("lgi-props:%s", g_type_name (gtype));
+  pc->slots_quark = g_quark_from_string (name);
+  g_free (name);
+  pc->get_fallback = lua_touserdata (L, 3);
+  pc->set_fallback = lua_touserdata (L, 4);
+  g_type_set_qdata (gtype, property_class_quark, pc);
+
+  lua_pushlightuserdata (L, property_get);
+  lua_pushlightuserdata (L, property_set);
+  return 2;
+}
+
 /* Object API table. */
 static const luaL_Reg object_api_reg[] = {
   { "query", object_query },
   { "field", object_field },
   { "new", object_new },
   { "env", object_env },
+  { "get_column", object_get_column },
+  { "set_column", object_set_column },
+  { "properties", object_properties },
   { NULL, NULL }
 };
 
@@ -592,6 +937,8 @@ lgi_object_init (lua_State *L)
 {
   char *id;
 
+  property_class_quark = g_quark_from_static_string ("lgi-property-class");
+
   /* Register metatable. */
   lua_pushlightuserdata (L, &object_mt);
   lua_newtable (L);
@@ -0,0 +1,20 @@
+------------------------------------------------------------------------------
+--
+--  lgi GLib MainContext support
+--
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+local lgi = require 'lgi'
+local core = require 'lgi.core'
+
+local GLib = lgi.GLib
+local MainContext = GLib.MainContext
+
+-- Creates poller, which allows driving iterations of the context
+-- step by step from foreign event loop.
+function MainContext:poller()
+   return core.poll.new(self)
+end
@@ -0,0 +1,22 @@
+------------------------------------------------------------------------------
+--
+--  lgi GLib MappedFile support
+--
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+local lgi = require 'lgi'
+local core = require 'lgi.core'
+local GLib = lgi.GLib
+local MappedFile = GLib.MappedFile
+
+-- Define length querying operation.
+MappedFile._len = MappedFile.get_length
+
+-- Returns read-only view of the mapped contents.  The view keeps the
+-- mapping alive, so the MappedFile instance itself can be released.
+function MappedFile:view()
+   return core.bytes.view(self)
+end
@@ -272,12 +272,24 @@ function Variant:_element(variant, name)
    return variant_element(self, variant, name)
 end
 
+-- Children are retrieved natively, basic values are unpacked without
+-- creating child GLib.Variant instances.
+local function variant_unpack(value, unpacked)
+   if unpacked == false then return variant_get(value) end
+   return value
+end
+
 function Variant:_access_index(variant, index, ...)
    assert(select('#', ...) == 0, 'GLib.Variant is not writable')
-   if (Variant.is_container(variant) and
-       Variant.n_children(variant) >= index) then
-      return Variant.get_child_value(variant, index - 1).value
-   end
+   return variant_unpack(core.variant.child(Variant, variant, index))
+end
+
+-- Looks up the key in dictionary with string keys, which are sorted
+-- (as e.g. produced by GLib.VariantDict or GVariant databases
+-- generated offline).  Uses binary search, so it is much faster than
+-- lookup_value for large dictionaries.
+function Variant:lookup_sorted(key)
+   return variant_unpack(core.variant.lookup(Variant, self, key))
 end
 
 -- Implementation of iterators over compound variant (simulating
@@ -337,3 +349,14 @@ function Variant.new_from_data(vt, data, trusted)
       -- held in upvalue for this closure.
       function() data = nil end)
 end
+
+-- Creates variant sharing memory of given bytes.view (e.g. view of
+-- GLib.MappedFile), GLib.Bytes or GLib.MappedFile, without copying
+-- the data.  Trusted variant (the default) is considered to be in
+-- normal form, so its data are not validated.
+function Variant.new_from_view(vt, view, trusted)
+   if type(vt) == 'string' then vt = VariantType.new(vt) end
+   if trusted == nil then trusted = true end
+   return Variant.new_from_bytes(vt, core.bytes.view(view):bytes(),
+				 trusted)
+end
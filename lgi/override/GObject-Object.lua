@@ -161,53 +161,71 @@ function Object.new(gtype, params, owns)
    end
 end
 
--- Prepare callbacks for get_property and set_property
-local get_property_guard, get_property_addr = core.marshal.callback(
-   gi.GObject.ObjectClass.fields.get_property.typeinfo.interface,
-   function(self, prop_id, value, pspec)
-      local name = pspec.name:gsub('%-', '_')
-      local prop_get = core.object.query(self, 'repo')._property_get[name]
-      if prop_get then
-	 value.value = prop_get(self)
-      else
-	 value.value = self.priv[name]
-      end
-end)
-
-local set_property_guard, set_property_addr = core.marshal.callback(
-   gi.GObject.ObjectClass.fields.get_property.typeinfo.interface,
-   function(self, prop_id, value, pspec)
-      local name = pspec.name:gsub('%-', '_')
-      local prop_set = core.object.query(self, 'repo')._property_set[name]
-      if prop_set then
-	 prop_set(self, value.value)
-      else
-	 self.priv[name] = value.value
-      end
-end)
-
-if not core.guards then core.guards = {} end
-core.guards.get_property = get_property_guard
-core.guards.set_property = set_property_guard
+-- Creates get_property and set_property callbacks of the class.
+-- Property names are precomputed, indexed by prop_id.
+local property_callback_type =
+   gi.GObject.ObjectClass.fields.get_property.typeinfo.interface
+local function property_callbacks(repotype, names)
+   local get_guard, get_addr = core.marshal.callback(
+      property_callback_type, function(self, prop_id, value)
+	 local name = names[prop_id]
+	 local prop_get = repotype._property_get[name]
+	 if prop_get then
+	    value.value = prop_get(self)
+	 else
+	    value.value = self.priv[name]
+	 end
+   end)
+   local set_guard, set_addr = core.marshal.callback(
+      property_callback_type, function(self, prop_id, value)
+	 local name = names[prop_id]
+	 local prop_set = repotype._property_set[name]
+	 if prop_set then
+	    prop_set(self, value.value)
+	 else
+	    self.priv[name] = value.value
+	 end
+   end)
+   repotype._guard.get_property = get_guard
+   repotype._guard.set_property = set_guard
+   return get_addr, set_addr
+end
 
 -- _class_init method on the Object will install all properties
 -- accumulated in _property table.  It will be called automatically on
--- derived classes during class initialization routine.
+-- derived classes during class initialization routine.  Properties
+-- listed in _property_native table and without custom accessors keep
+-- their values natively, without ever entering Lua.
 function Object:_class_init(class)
    if next(self._property) then
+      -- Assign prop_ids to properties.
+      local names, native, any_native = {}, {}, false
+      for name in pairs(self._property) do
+	 names[#names + 1] = name
+	 native[#names] = (self._property_native[name] and
+			   not self._property_get[name] and
+			   not self._property_set[name]) or false
+	 any_native = any_native or native[#names]
+      end
+
       -- First install get/set_property overrides, unless already present.
+      local get_addr, set_addr = property_callbacks(self, names)
+      if self._override.get_property or self._override.set_property then
+	 any_native = false
+      elseif any_native then
+	 get_addr, set_addr = core.object.properties(
+	    self._gtype, native, get_addr, set_addr)
+      end
       if not self._override.get_property then
-	 class.get_property = get_property_addr
+	 class.get_property = get_addr
       end
       if not self._override.set_property then
-	 class.set_property = set_property_addr
+	 class.set_property = set_addr
       end
 
       -- Install properties.
-      local prop_id = 0
-      for name, pspec in pairs(self._property) do
-	 prop_id = prop_id + 1
-	 class:install_property(prop_id, pspec)
+      for prop_id, name in ipairs(names) do
+	 class:install_property(prop_id, self._property[name])
       end
    end
 end
@@ -289,6 +307,21 @@ function Object:_access_property(object, prop, ...)
    end
 end
 
+-- Reads or writes the same property of many objects at once.
+-- Property is looked up once per class, values of basic types are
+-- marshalled natively, the rest through GObject.Value marshallers.
+local function column_unpack(value) return value.value end
+local function column_pack(gtype, value) return Value(gtype, value) end
+function Object.get_property_column(objects, name, values)
+   return core.object.get_column(objects, (name:gsub('_', '-')),
+				 column_unpack, values)
+end
+
+function Object.set_property_column(objects, name, values)
+   core.object.set_column(objects, (name:gsub('_', '-')), column_pack,
+			  values)
+end
+
 local quark_from_string = repo.GLib.quark_from_string
 local signal_lookup = repo.GObject.signal_lookup
 local signal_connect_closure_by_id = repo.GObject.signal_connect_closure_by_id
@@ -374,3 +407,25 @@ for _, name in pairs { 'bind_property', 'bind_property_full' } do
       Object._method[name] = InitiallyUnowned[name]
    end
 end
+
+-- Binds properties using native transformation described by table,
+-- without invoking Lua on every change of the source property.
+local BindingFlags = repo.GObject.BindingFlags
+local function binding_args(source, source_property, target,
+			    target_property, flags, transform)
+   return source, (source_property:gsub('_', '-')), target,
+   (target_property:gsub('_', '-')), BindingFlags(flags or 0), transform
+end
+
+function Object:bind_property_transform(...)
+   return core.binding.new(binding_args(self, ...))
+end
+
+function Object.bind_properties(bindings)
+   local args = {}
+   for i = 1, #bindings do
+      local b = bindings[i]
+      args[i] = { binding_args(b[1], b[2], b[3], b[4], b[5], b[6]) }
+   end
+   return core.binding.new_all(args)
+end
@@ -0,0 +1,67 @@
+------------------------------------------------------------------------------
+--
+--  lgi Gio ValueListModel support
+--
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+local pairs = pairs
+
+local lgi = require 'lgi'
+local core = require 'lgi.core'
+local GObject = lgi.GObject
+local Gio = lgi.Gio
+
+-- List model holding plain Lua values.  Values are kept in the priv
+-- table of the model and wrapped into GObject items only when the
+-- item is requested; recently wrapped items are cached natively.
+if not Gio.ListModel then return end
+
+local ValueListItem = GObject.Object:derive('Gio.ValueListItem')
+function ValueListItem:get_value()
+   return self.priv.value
+end
+
+local function wrap_value(value)
+   local item = ValueListItem()
+   item.priv.value = value
+   return item
+end
+
+local ValueListModel = GObject.Object:derive('Gio.ValueListModel',
+					     { Gio.ListModel })
+local override = ValueListModel._override[Gio.ListModel._name]
+for name, addr in pairs(core.gio.value_list_vfuncs()) do
+   override[name] = addr
+end
+ValueListModel.Item = ValueListItem
+
+function ValueListModel.new(values, wrap, item_type, cache_size)
+   local model = ValueListModel()
+   if not wrap then
+      wrap, item_type = wrap_value, item_type or ValueListItem
+   end
+   core.gio.value_list_init(model, values or {}, wrap, item_type,
+			    cache_size)
+   return model
+end
+
+function ValueListModel:get_value(position)
+   return core.gio.value_list_get(self, position)
+end
+
+function ValueListModel:splice(position, n_removals, values)
+   core.gio.value_list_splice(self, position, n_removals, values or {})
+end
+
+function ValueListModel:replace(position, values)
+   core.gio.value_list_splice(self, position, #values, values)
+end
+
+function ValueListModel:append(values)
+   core.gio.value_list_splice(self, self:get_n_items(), 0, values)
+end
+
+Gio.ValueListModel = ValueListModel
@@ -63,38 +63,73 @@ function Gio.Async.start(func, cancellable, io_priority)
    end
 end
 
-function Gio.Async.call(func, cancellable, io_priority)
-   -- Create mainloop which will create modality.
-   local loop = GLib.MainLoop()
-   local results
-
-   -- Create coroutine around function wrapper which will invoke
-   -- target and then terminate the loop.
-   local coro = coroutine.create(function(...)
-	 (function(...)
-	     results = { n = select('#', ...), ... }
-	     loop:quit()
-	 end)(func(...))
-   end)
+-- Results of Gio.Async.call coroutines which did not finish during
+-- their first resume.  Contains 'false' while the coroutine is still
+-- waiting and table with results once it finishes.  When the
+-- coroutine fails, the table contains 'failed' flag and the error.
+local async_results = setmetatable({}, { __mode = 'k' })
+
+-- Resumes Gio.Async.call coroutine from the completion callback,
+-- keeping the error for the spinning caller instead of losing it in
+-- the mainloop.
+local function async_resume(coro, ...)
+   local ok, err = coroutine.resume(coro, ...)
+   if not ok then async_results[coro] = { failed = true, n = 1, err } end
+end
 
-   -- Register coroutine.
-   register_async(coro, cancellable, io_priority)
+-- Returns completion callback resuming the running coroutine.
+local function async_callback(context)
+   local coro = coroutine.running()
+   if context.capture then
+      return function(...) async_resume(coro, ...) end
+   end
+   return coro
+end
+
+-- Captures results of finished Gio.Async.call routine.  When the
+-- routine finished synchronously, results are just passed through to
+-- the resumer, otherwise they are stored for the spinning caller.
+local function async_capture(coro, ...)
+   if async_results[coro] == false then
+      async_results[coro] = { n = select('#', ...), ... }
+   end
+   return ...
+end
+
+-- Body of all Gio.Async.call coroutines.
+local function async_body(func, ...)
+   return async_capture(coroutine.running(), func(...))
+end
+
+-- Processes results of the first resume of Gio.Async.call coroutine.
+local function async_return(coro, ok, ...)
+   if not ok then error(..., 0) end
+   if coroutine.status(coro) == 'dead' then return ... end
+
+   -- Coroutine waits for some asynchronous operation, so spin the
+   -- context of the calling thread until it finishes.
+   async_results[coro] = false
+   local context = (GLib.MainContext.get_thread_default()
+		    or GLib.MainContext.default())
+   while coroutine.status(coro) ~= 'dead' do
+      context:iteration(true)
+   end
+   local results = async_results[coro] or { n = 0 }
+   async_results[coro] = nil
+   if results.failed then error(results[1], 0) end
+   return unpack(results, 1, results.n)
+end
 
+function Gio.Async.call(func, cancellable, io_priority)
    -- Return starter closure.
    return function(...)
-      -- Spawn it inside idle handler, to avoid hang in case that
-      -- coroutine finishes during its first resuming.
-      local args = { n = select('#', ...), ... }
-      GLib.idle_add(
-	 GLib.PRIORITY_DEFAULT, function()
-	    coroutine.resume(coro, unpack(args, 1, args.n))
-      end)
-
-      -- Spin the loop.
-      loop:run()
-
-      -- Unpack results.
-      return unpack(results, 1, results.n)
+      -- Resume the coroutine directly; when it finishes without
+      -- waiting, results are returned without touching the mainloop
+      -- at all.
+      local coro = coroutine.create(async_body)
+      register_async(coro, cancellable, io_priority)
+      async_context[coro].capture = true
+      return async_return(coro, coroutine.resume(coro, func, ...))
    end
 end
 
@@ -167,7 +202,7 @@ local function async_access(element, process_yield)
 	    index = index + 1
 	 end
       end
-      args[element.in_args] = coroutine.running()
+      args[element.in_args] = async_callback(context)
 
       element.async(unpack(args, 1, element.in_args))
       return element.finish(process_yield(coroutine.yield()))
@@ -256,6 +291,46 @@ for _, name in pairs { 'read', 'read_all', 'read_async' } do
    end
 end
 
+-- Batched directory enumeration.  Requested attributes of the whole
+-- batch of infos are decoded natively into plain Lua tables, avoiding
+-- creation of FileInfo proxies and per-attribute method calls.
+function Gio.FileEnumerator:next_batch(n, attrs, cancellable)
+   return core.gio.next_batch(self, n, attrs, cancellable)
+end
+
+function Gio.FileEnumerator:async_next_batch(n, attrs)
+   local context = async_context[coroutine.running()]
+   if not context then
+      error("Gio.FileEnumerator.async_next_batch: called out of async context",
+	    2)
+   end
+   if type(n) ~= 'number' or n < 0 then
+      error("Gio.FileEnumerator.async_next_batch: bad number of files", 2)
+   end
+   self:next_files_async(n, context.io_priority, context.cancellable,
+			 async_callback(context))
+   local _, result = coroutine.yield()
+   return core.gio.next_batch_finish(self, result, attrs)
+end
+
+-- Buffered stream classes.  Derived input stream implements
+-- do_fill(buffer) method, which fills bytes.bytearray buffer and
+-- returns number of stored bytes (0 on EOF), or returns the data as
+-- a string.  Derived output stream implements do_drain(data), which
+-- writes out a whole chunk of buffered data.  Reads and writes of the
+-- consumers are served natively from the buffer.
+for kind, stream in pairs { input = Gio.InputStream,
+			     output = Gio.OutputStream } do
+   function stream:derive_buffered(typename, chunk_size, ifaces)
+      local new_class = self:derive(typename, ifaces)
+      local vfuncs = core.gio.buffered(new_class._gtype, kind, chunk_size)
+      for name, addr in pairs(vfuncs) do
+	 new_class._override[name] = addr
+      end
+      return new_class
+   end
+end
+
 -- Add preconditions for auto-loading DBus overrides.
 Gio._precondition = {}
 for _, name in pairs {
@@ -264,3 +339,7 @@ for _, name in pairs {
 } do
    Gio._precondition['DBus' .. name] = 'Gio-DBus'
 end
+
+-- List model holding Lua values registers its types, so it is loaded
+-- only when it is used.
+Gio._precondition.ValueListModel = 'Gio-ValueListModel'
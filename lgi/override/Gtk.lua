@@ -290,6 +290,32 @@ end
 -- Map adding of tags in constructor array part to add() method.
 Gtk.TextTagTable._container_add = Gtk.TextTagTable.add
 
+-------------------------------- Gtk.TextBuffer overrides.
+-- Symbols used by native batched insertion and tagging.
+local text_buffer_api = {
+   get_iter_at_offset = core.gi.Gtk.TextBuffer.methods.get_iter_at_offset,
+   get_end_iter = core.gi.Gtk.TextBuffer.methods.get_end_iter,
+   get_tag_table = core.gi.Gtk.TextBuffer.methods.get_tag_table,
+   insert = core.gi.Gtk.TextBuffer.methods.insert,
+   apply_tag = core.gi.Gtk.TextBuffer.methods.apply_tag,
+   iter_get_offset = core.gi.Gtk.TextIter.methods.get_offset,
+   tag_table_lookup = core.gi.Gtk.TextTagTable.methods.lookup,
+   iter_size = core.gi.Gtk.TextIter.size,
+}
+
+-- Inserts array of runs { text, tag1, tag2, ... } at given character
+-- offset (end of the buffer by default), returns offset after the
+-- inserted text.  Tags can be given as instances or names.
+function Gtk.TextBuffer:insert_runs(runs, offset)
+   return core.gtk.insert_runs(text_buffer_api, self, runs, offset)
+end
+
+-- Applies tag on all ranges given by flat array of character offsets
+-- { start1, end1, start2, end2, ... }.
+function Gtk.TextBuffer:apply_tag_ranges(tag, offsets)
+   core.gtk.apply_tag_ranges(text_buffer_api, self, tag, offsets)
+end
+
 -------------------------------- Gtk.TreeModel and relatives.
 Gtk.TreeModel._attribute = {}
 
@@ -414,6 +440,39 @@ function Gtk.TreeStore:append(parent, values)
    return iter
 end
 
+-- Sorting of stores by precomputed keys.  Key is either model column
+-- number, or function(model, iter) returning the key, which is called
+-- only once per row.  Rows are then reordered natively.
+local function store_sort_api(store, reorder)
+   return {
+      iter_children = core.gi.Gtk.TreeModel.methods.iter_children,
+      iter_next = core.gi.Gtk.TreeModel.methods.iter_next,
+      get_value = core.gi.Gtk.TreeModel.methods.get_value,
+      [reorder] = core.gi.Gtk[store].methods.reorder,
+      iter_size = core.gi.Gtk.TreeIter.size,
+      iter_type = Gtk.TreeIter,
+   }
+end
+local function store_sort_by(api)
+   return function(store, key, descending, parent)
+      if type(key) == 'number' then
+	 key = key - 1
+      else
+	 local keys, count = {}, 0
+	 for iter in store:pairs(parent) do
+	    count = count + 1
+	    keys[count] = key(store, iter)
+	 end
+	 key = keys
+      end
+      core.gtk.sort_store(api, store, key, descending, parent)
+   end
+end
+Gtk.ListStore.sort_by = store_sort_by(
+   store_sort_api('ListStore', 'list_reorder'))
+Gtk.TreeStore.sort_by = store_sort_by(
+   store_sort_api('TreeStore', 'tree_reorder'))
+
 -- Add missing constants, defined as anonymous enums in C headers, which
 -- is not supported by GIR yet.
 Gtk.TreeSortable.DEFAULT_SORT_COLUMN_ID = -1
@@ -463,6 +522,48 @@ function Gtk.CellLayout:add(def)
    if def.data_func then self:set_cell_data_func(def[1], def.data_func) end
 end
 
+-- Symbols used by native cell attribute mappings.
+local cell_layout_api = {
+   set_cell_data_func = core.gi.Gtk.CellLayout.methods.set_cell_data_func,
+   get_value = core.gi.Gtk.TreeModel.methods.get_value,
+}
+
+-- Maps model columns to cell properties, without calling back into
+-- Lua during rendering.  Definition is { cell, { property = spec } },
+-- spec is either column number or table { col = column, map = {
+-- [model_value] = property_value }, default = property_value } or
+-- { col = column, format = printf_format }.
+function Gtk.CellLayout:map_attributes(def)
+   local cell, attrs = def[1], {}
+   for name, spec in pairs(def[2]) do
+      if type(spec) == 'number' then
+	 self:add_attribute(cell, name, spec - 1)
+      else
+	 local pspec = GObject.Object._class.find_property(
+	    cell._class, (name:gsub('_', '-')))
+	 if not pspec then
+	    error(("%s: no property `%s'"):format(
+		     core.object.query(cell, 'repo')._name, name), 2)
+	 end
+	 local attr = { pspec.name, spec.col - 1, format = spec.format }
+	 if spec.map then
+	    attr.map = {}
+	    for key, value in pairs(spec.map) do
+	       attr.map[#attr.map + 1] = key
+	       attr.map[#attr.map + 1] = GObject.Value(pspec.value_type, value)
+	    end
+	 end
+	 if spec.default ~= nil then
+	    attr.default = GObject.Value(pspec.value_type, spec.default)
+	 end
+	 attrs[#attrs + 1] = attr
+      end
+   end
+   if #attrs > 0 then
+      core.gtk.map_attributes(cell_layout_api, self, cell, attrs)
+   end
+end
+
 -- Unfortunately, CellView is interface often implemented by descendants
 -- of Gtk.Container, so we cannot reuse generic _container_add here,
 -- because it is already occupied by implementing container's ctor.  So
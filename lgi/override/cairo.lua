@@ -8,8 +8,8 @@
 --
 ------------------------------------------------------------------------------
 
-local assert, pairs, ipairs, setmetatable, table, rawget, type
-   = assert, pairs, ipairs, setmetatable, table, rawget, type
+local assert, pairs, ipairs, setmetatable, table, rawget, type, next
+   = assert, pairs, ipairs, setmetatable, table, rawget, type, next
 local lgi = require 'lgi'
 local cairo = lgi.cairo
 
@@ -268,7 +268,7 @@ for _, info in ipairs {
 	 line_to = { ti.double, ti.double },
 	 move_to = { ti.double, ti.double },
 	 rectangle = { ti.double, ti.double, ti.double, ti.double },
-	 -- glyph_path,
+	 -- glyph_path, implemented below using glyph buffers
 	 text_path = { ti.utf8 },
 	 rel_curve_to = { ti.double, ti.double, ti.double,
 			  ti.double, ti.double, ti.double },
@@ -306,10 +306,11 @@ for _, info in ipairs {
 	 set_scaled_font = { cairo.ScaledFont },
 	 get_scaled_font = { ret = cairo.ScaledFont },
 	 show_text = { ti.utf8 },
-	 -- show_glyphs, show_text_glyphs
+	 -- show_glyphs implemented below using glyph buffers
+	 -- show_text_glyphs
 	 font_extents = { cairo.FontExtents },
 	 text_extents = { ti.utf8, cairo.TextExtents },
-	 -- glyph extents
+	 -- glyph_extents implemented below using glyph buffers
       },
 
       properties = {
@@ -842,6 +843,60 @@ for _, struct in pairs(cairo._struct) do
    end
 end
 
+-- Batch geometry operations.  Points are either flat array { x1, y1,
+-- x2, y2, ... } or bytes.bytearray of packed doubles, transformed in
+-- place.
+function cairo.Matrix._method:transform_points(points)
+   return core.cairo.transform_points(points, self.xx, self.yx, self.xy,
+				      self.yy, self.x0, self.y0)
+end
+
+function cairo.Matrix._method:transform_distances(points)
+   return core.cairo.transform_points(points, self.xx, self.yx, self.xy,
+				      self.yy, self.x0, self.y0, true)
+end
+
+-- Rectangles of the region as flat array { x1, y1, width1, height1,
+-- x2, ... } and creation of region from such array or from
+-- bytes.bytearray of packed 32bit integers.
+function cairo.Region._method:rectangles()
+   return core.cairo.region_rectangles(cairo._module, cairo.Region, self)
+end
+
+function cairo.Region._method.from_rectangles(rects)
+   return core.cairo.region_create(cairo._module, cairo.Region, rects)
+end
+
+-- Glyph buffers, holding packed native array of glyphs.  Buffers can
+-- be filled from flat arrays { index1, x1, y1, index2, ... },
+-- bytes.bytearray of packed cairo_glyph_t or other glyph buffers.
+-- Glyph methods accept either glyph buffer or any of the sources.
+cairo.GlyphBuffer = setmetatable({}, {
+   __call = function(_, source) return core.cairo.glyphs(source) end })
+cairo.GlyphBuffer.new = core.cairo.glyphs
+
+function cairo.Context._method:show_glyphs(glyphs)
+   core.cairo.glyphs_call(cairo._module, 'cairo_show_glyphs', cairo.Context,
+			  self, glyphs)
+end
+
+function cairo.Context._method:glyph_path(glyphs)
+   core.cairo.glyphs_call(cairo._module, 'cairo_glyph_path', cairo.Context,
+			  self, glyphs)
+end
+
+function cairo.Context._method:glyph_extents(glyphs)
+   return core.cairo.glyphs_call(cairo._module, 'cairo_glyph_extents',
+				 cairo.Context, self, glyphs, cairo.TextExtents)
+end
+
+function cairo.ScaledFont._method:glyph_extents(glyphs)
+   return core.cairo.glyphs_call(cairo._module,
+				 'cairo_scaled_font_glyph_extents',
+				 cairo.ScaledFont, self, glyphs,
+				 cairo.TextExtents)
+end
+
 -- Implementation of Context.dash operations.  Since ffi does not
 -- support arrays of doubles, we cheat here and use array of structs
 -- containing only single 'double' field.
@@ -909,3 +964,105 @@ function cairo.Path:pairs()
       return type, points
    end
 end
+
+-- Cache of drawings recorded into recording surfaces.  Entries are
+-- stored in entries[key][width][height] and linked into the list in
+-- the order of their use, most recently used right after the list
+-- head.  They are evicted from the tail of the list when estimated
+-- memory cost of all entries exceeds the budget.  The cost of the
+-- entry is estimated as the size of ARGB32 raster of the same
+-- dimensions.
+local draw_cache = { entries = {}, cost = 0, budget = 32 * 1024 * 1024 }
+draw_cache.prev, draw_cache.next = draw_cache, draw_cache
+
+local function draw_cache_unlink(entry)
+   entry.prev.next, entry.next.prev = entry.next, entry.prev
+end
+
+local function draw_cache_link(entry)
+   entry.prev, entry.next = draw_cache, draw_cache.next
+   draw_cache.next.prev, draw_cache.next = entry, entry
+end
+
+local function draw_cache_remove(entry)
+   draw_cache_unlink(entry)
+   draw_cache.cost = draw_cache.cost - entry.cost
+   local widths = draw_cache.entries[entry.key]
+   local heights = widths[entry.width]
+   heights[entry.height] = nil
+   if not next(heights) then
+      widths[entry.width] = nil
+      if not next(widths) then draw_cache.entries[entry.key] = nil end
+   end
+end
+
+local function draw_cache_evict(budget)
+   while draw_cache.cost > budget and draw_cache.prev ~= draw_cache do
+      draw_cache_remove(draw_cache.prev)
+   end
+end
+
+function cairo.cached(key, width, height, draw)
+   local widths = draw_cache.entries[key]
+   local heights = widths and widths[width]
+   local entry = heights and heights[height]
+   if entry then
+      -- Move the entry to the head of the list.
+      if draw_cache.next ~= entry then
+	 draw_cache_unlink(entry)
+	 draw_cache_link(entry)
+      end
+      return entry.surface
+   end
+
+   -- Record the drawing routine.
+   local surface = cairo.RecordingSurface.create(
+      cairo.Content.COLOR_ALPHA,
+      cairo.Rectangle { x = 0, y = 0, width = width, height = height })
+   local cr = cairo.Context.create(surface)
+   draw(cr, width, height)
+   entry = { key = key, width = width, height = height, surface = surface,
+	     cost = 4 * width * height }
+   if not widths then
+      widths = {}
+      draw_cache.entries[key] = widths
+   end
+   if not heights then
+      heights = {}
+      widths[width] = heights
+   end
+   heights[height] = entry
+   draw_cache_link(entry)
+   draw_cache.cost = draw_cache.cost + entry.cost
+   draw_cache_evict(draw_cache.budget)
+   return surface
+end
+
+function cairo.cached_budget(budget)
+   local old_budget = draw_cache.budget
+   if budget then
+      draw_cache.budget = budget
+      draw_cache_evict(budget)
+   end
+   return old_budget
+end
+
+function cairo.cached_flush(key)
+   if key == nil then
+      draw_cache_evict(-1)
+   else
+      for _, heights in pairs(draw_cache.entries[key] or {}) do
+	 for _, entry in pairs(heights) do
+	    draw_cache_remove(entry)
+	 end
+      end
+   end
+end
+
+function cairo.Context._method:paint_cached(key, width, height, draw, x, y)
+   local surface = cairo.cached(key, width, height, draw)
+   self:save()
+   self:set_source_surface(surface, x or 0, y or 0)
+   self:paint()
+   self:restore()
+end
@@ -0,0 +1,349 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Integration of GMainContext into foreign event loops.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+#ifdef __linux__
+#define LGI_HAVE_EPOLL 1
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/* Metatable name of poller userdata. */
+#define LGI_POLLER "lgi.poll.poller"
+
+/* Poller drives single iteration of GMainContext in separate steps,
+   so that waiting for the file descriptors can be done by external
+   event loop.  Pollfd set is kept in buffer which is reused between
+   iterations. */
+typedef struct _Poller
+{
+  /* Context which is driven. */
+  GMainContext *context;
+
+  /* Current pollfd set, filled by query. */
+  GPollFD *fds;
+  gint n_fds, allocated;
+
+  /* Results of last prepare and query. */
+  gint max_priority, timeout;
+
+  /* Whether the context is acquired by the poller. */
+  guint acquired : 1;
+
+  /* Whether revents were set by the caller since last query. */
+  guint revents_set : 1;
+
+#ifdef LGI_HAVE_EPOLL
+  /* Aggregated epoll descriptor, -1 if not requested yet. */
+  int epfd;
+
+  /* Copy of pollfd set currently registered in epfd. */
+  GPollFD *registered;
+  gint n_registered, registered_allocated;
+#endif
+} Poller;
+
+#define poller_get(L, narg) ((Poller *) luaL_checkudata (L, narg, LGI_POLLER))
+
+/* Makes sure that buffer holds at least 'size' pollfds. */
+static void
+poller_grow (GPollFD **fds, gint *allocated, gint size)
+{
+  if (size > *allocated)
+    {
+      *allocated = MAX (size, *allocated * 2);
+      *fds = g_renew (GPollFD, *fds, *allocated);
+    }
+}
+
+static void
+poller_release (Poller *poller)
+{
+  if (poller->acquired)
+    {
+      g_main_context_release (poller->context);
+      poller->acquired = FALSE;
+    }
+}
+
+#ifdef LGI_HAVE_EPOLL
+static guint32
+poller_epoll_events (gushort events)
+{
+  guint32 result = 0;
+  if (events & G_IO_IN)
+    result |= EPOLLIN;
+  if (events & G_IO_OUT)
+    result |= EPOLLOUT;
+  if (events & G_IO_PRI)
+    result |= EPOLLPRI;
+  return result;
+}
+
+/* Synchronizes set of descriptors registered in the epoll descriptor
+   with the set returned by last query. */
+static void
+poller_epoll_sync (Poller *poller)
+{
+  struct epoll_event ev;
+  gint i, j;
+
+  /* Typically the set does not change between iterations. */
+  if (poller->n_fds == poller->n_registered)
+    {
+      for (i = 0; i < poller->n_fds; i++)
+	if (poller->fds[i].fd != poller->registered[i].fd
+	    || poller->fds[i].events != poller->registered[i].events)
+	  break;
+      if (i == poller->n_fds)
+	return;
+    }
+
+  for (i = 0; i < poller->n_registered; i++)
+    epoll_ctl (poller->epfd, EPOLL_CTL_DEL, poller->registered[i].fd, NULL);
+
+  for (i = 0; i < poller->n_fds; i++)
+    {
+      /* The same descriptor can be polled by more sources; register
+	 it only once with union of requested events. */
+      memset (&ev, 0, sizeof (ev));
+      ev.data.fd = poller->fds[i].fd;
+      for (j = 0; j < poller->n_fds; j++)
+	if (poller->fds[j].fd == poller->fds[i].fd)
+	  ev.events |= poller_epoll_events (poller->fds[j].events);
+      if (epoll_ctl (poller->epfd, EPOLL_CTL_ADD, poller->fds[i].fd, &ev) < 0
+	  && errno != EEXIST)
+	g_warning ("failed to add fd %d to epoll set: %s",
+		   poller->fds[i].fd, g_strerror (errno));
+    }
+
+  poller_grow (&poller->registered, &poller->registered_allocated,
+	       poller->n_fds);
+  if (poller->n_fds > 0)
+    memcpy (poller->registered, poller->fds,
+	    poller->n_fds * sizeof (GPollFD));
+  poller->n_registered = poller->n_fds;
+}
+#endif
+
+static int
+poller_gc (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  poller_release (poller);
+#ifdef LGI_HAVE_EPOLL
+  if (poller->epfd >= 0)
+    close (poller->epfd);
+  g_free (poller->registered);
+#endif
+  g_free (poller->fds);
+  g_main_context_unref (poller->context);
+  return 0;
+}
+
+/* ready = poller:prepare() */
+static int
+poller_prepare (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  if (!poller->acquired)
+    {
+      if (!g_main_context_acquire (poller->context))
+	return luaL_error (L, "main context is owned by another thread");
+      poller->acquired = TRUE;
+    }
+
+  lua_pushboolean (L, g_main_context_prepare (poller->context,
+					      &poller->max_priority));
+  return 1;
+}
+
+/* n_fds, timeout = poller:query() */
+static int
+poller_query (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  gint n_fds;
+  luaL_argcheck (L, poller->acquired, 1, "prepare() not called");
+  for (;;)
+    {
+      n_fds = g_main_context_query (poller->context, poller->max_priority,
+				    &poller->timeout, poller->fds,
+				    poller->allocated);
+      if (n_fds <= poller->allocated)
+	break;
+      poller_grow (&poller->fds, &poller->allocated, n_fds);
+    }
+
+  poller->n_fds = n_fds;
+  poller->revents_set = FALSE;
+#ifdef LGI_HAVE_EPOLL
+  if (poller->epfd >= 0)
+    poller_epoll_sync (poller);
+#endif
+
+  lua_pushinteger (L, n_fds);
+  lua_pushinteger (L, poller->timeout);
+  return 2;
+}
+
+/* fd, events = poller:fd(index) */
+static int
+poller_fd (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  int index = luaL_checkint (L, 2);
+  luaL_argcheck (L, index > 0 && index <= poller->n_fds, 2, "bad index");
+  lua_pushinteger (L, poller->fds[index - 1].fd);
+  lua_pushinteger (L, poller->fds[index - 1].events);
+  return 2;
+}
+
+/* poller:revents(index, revents) */
+static int
+poller_revents (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  int index = luaL_checkint (L, 2);
+  luaL_argcheck (L, index > 0 && index <= poller->n_fds, 2, "bad index");
+  if (!poller->revents_set)
+    {
+      int i;
+      for (i = 0; i < poller->n_fds; i++)
+	poller->fds[i].revents = 0;
+      poller->revents_set = TRUE;
+    }
+  poller->fds[index - 1].revents = luaL_checkint (L, 3);
+  return 0;
+}
+
+/* ready = poller:check() */
+static int
+poller_check (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  gboolean ready;
+  luaL_argcheck (L, poller->acquired, 1, "prepare() not called");
+
+  /* If the caller did not provide revents itself, collect them
+     without waiting; the outer loop already waited for us. */
+  if (!poller->revents_set && poller->n_fds > 0)
+    g_poll (poller->fds, poller->n_fds, 0);
+
+  ready = g_main_context_check (poller->context, poller->max_priority,
+				poller->fds, poller->n_fds);
+  if (!ready)
+    poller_release (poller);
+  lua_pushboolean (L, ready);
+  return 1;
+}
+
+/* poller:dispatch() */
+static int
+poller_dispatch (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+  gpointer state_lock = lgi_state_get_lock (L);
+  luaL_argcheck (L, poller->acquired, 1, "prepare() not called");
+
+  /* Dispatched sources can do arbitrary work, so let other threads
+     enter the state meanwhile. */
+  lgi_state_leave (state_lock);
+  g_main_context_dispatch (poller->context);
+  lgi_state_enter (state_lock);
+  poller_release (poller);
+  return 0;
+}
+
+/* fd = poller:epoll() */
+static int
+poller_epoll (lua_State *L)
+{
+  Poller *poller = poller_get (L, 1);
+#ifdef LGI_HAVE_EPOLL
+  if (poller->epfd < 0)
+    {
+      poller->epfd = epoll_create1 (EPOLL_CLOEXEC);
+      if (poller->epfd < 0)
+	{
+	  lua_pushnil (L);
+	  lua_pushstring (L, g_strerror (errno));
+	  return 2;
+	}
+      poller->n_registered = 0;
+      poller_epoll_sync (poller);
+    }
+  lua_pushinteger (L, poller->epfd);
+  return 1;
+#else
+  (void) poller;
+  lua_pushnil (L);
+  lua_pushstring (L, "epoll is not supported on this platform");
+  return 2;
+#endif
+}
+
+static const luaL_Reg poller_methods[] = {
+  { "prepare", poller_prepare },
+  { "query", poller_query },
+  { "fd", poller_fd },
+  { "revents", poller_revents },
+  { "check", poller_check },
+  { "dispatch", poller_dispatch },
+  { "epoll", poller_epoll },
+  { NULL, NULL }
+};
+
+/* poller = core.poll.new([context]) */
+static int
+poll_new (lua_State *L)
+{
+  GMainContext *context = NULL;
+  Poller *poller;
+
+  lgi_type_get_repotype (L, G_TYPE_MAIN_CONTEXT, NULL);
+  lgi_record_2c (L, 1, &context, FALSE, FALSE, TRUE, FALSE);
+
+  poller = lua_newuserdata (L, sizeof (Poller));
+  memset (poller, 0, sizeof (Poller));
+  poller->context = g_main_context_ref (context ? context
+					: g_main_context_default ());
+#ifdef LGI_HAVE_EPOLL
+  poller->epfd = -1;
+#endif
+  luaL_getmetatable (L, LGI_POLLER);
+  lua_setmetatable (L, -2);
+  return 1;
+}
+
+static const luaL_Reg poll_reg[] = {
+  { "new", poll_new },
+  { NULL, NULL }
+};
+
+void
+lgi_poll_init (lua_State *L)
+{
+  /* Register poller metatable. */
+  luaL_newmetatable (L, LGI_POLLER);
+  lua_pushcfunction (L, poller_gc);
+  lua_setfield (L, -2, "__gc");
+  lua_newtable (L);
+  luaL_register (L, NULL, poller_methods);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
+
+  /* Register poll API. */
+  lua_newtable (L);
+  luaL_register (L, NULL, poll_reg);
+  lua_setfield (L, -2, "poll");
+}
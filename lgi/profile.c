@@ -0,0 +1,276 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Sampling profiler attributing time to Lua frames and native calls.
+ */
+
+#include "lgi.h"
+
+volatile gint lgi_profile_active = 0;
+
+/* Sampler thread only counts ticks into 'pending'.  Pending ticks
+   are attributed to the current Lua stack and the native function
+   being executed whenever the execution switches between Lua and
+   native code, and periodically from the count hook. */
+static volatile gint profile_pending;
+static GThread *profile_thread;
+static gulong profile_interval;
+
+/* Native function currently being executed by the thread, name is
+   NULL when running Lua.  Kept per thread, because native calls
+   release the state lock and other threads interleave with them. */
+typedef struct _ProfileCurrent
+{
+  const gchar *scope;
+  const gchar *name;
+} ProfileCurrent;
+static GPrivate profile_current = G_PRIVATE_INIT (g_free);
+
+/* Collapsed stacks and their sample counts. */
+static GHashTable *profile_stacks;
+static GMutex profile_lock;
+
+static gpointer
+profile_sampler (gpointer data)
+{
+  (void) data;
+  while (g_atomic_int_get (&lgi_profile_active))
+    {
+      g_usleep (profile_interval);
+      g_atomic_int_inc (&profile_pending);
+    }
+  return NULL;
+}
+
+static ProfileCurrent *
+profile_current_get (void)
+{
+  ProfileCurrent *current = g_private_get (&profile_current);
+  if (G_UNLIKELY (current == NULL))
+    {
+      current = g_new0 (ProfileCurrent, 1);
+      g_private_set (&profile_current, current);
+    }
+  return current;
+}
+
+/* Appends description of the frame to the collapsed stack. */
+static void
+profile_append_frame (GString *stack, lua_Debug *ar)
+{
+  if (stack->len > 0)
+    g_string_append_c (stack, ';');
+  if (*ar->what == 'C')
+    g_string_append (stack, ar->name ? ar->name : "[C]");
+  else if (ar->name != NULL)
+    g_string_append_printf (stack, "%s (%s:%d)", ar->name, ar->short_src,
+			    ar->linedefined);
+  else
+    g_string_append_printf (stack, "%s:%d", ar->short_src, ar->linedefined);
+}
+
+/* Attributes pending ticks to the current stack of the calling
+   thread. */
+static void
+profile_flush (lua_State *L)
+{
+  ProfileCurrent *current;
+  GString *stack;
+  lua_Debug ar;
+  gint n, level, depth;
+  gpointer count;
+
+  do
+    n = g_atomic_int_get (&profile_pending);
+  while (n > 0
+	 && !g_atomic_int_compare_and_exchange (&profile_pending, n, 0));
+  if (n <= 0)
+    return;
+
+  /* Find out the depth of the stack, and walk it from the outermost
+     frame.  Native frame at the top is the one invoking current
+     native function, so it is skipped. */
+  for (depth = 0; lua_getstack (L, depth, &ar); depth++)
+    ;
+  stack = g_string_sized_new (256);
+  for (level = depth - 1; level >= 0; level--)
+    {
+      lua_getstack (L, level, &ar);
+      lua_getinfo (L, "Sn", &ar);
+      if (level > 0 || *ar.what != 'C')
+	profile_append_frame (stack, &ar);
+    }
+
+  current = profile_current_get ();
+  if (current->name != NULL)
+    {
+      if (stack->len > 0)
+	g_string_append_c (stack, ';');
+      if (current->scope != NULL && *current->scope != '\0')
+	g_string_append_printf (stack, "%s.", current->scope);
+      g_string_append (stack, *current->name ? current->name : "[native]");
+    }
+  if (stack->len == 0)
+    g_string_append (stack, "[unknown]");
+
+  g_mutex_lock (&profile_lock);
+  if (profile_stacks != NULL)
+    {
+      count = g_hash_table_lookup (profile_stacks, stack->str);
+      g_hash_table_replace (profile_stacks, g_string_free (stack, FALSE),
+			    GINT_TO_POINTER (GPOINTER_TO_INT (count) + n));
+    }
+  else
+    g_string_free (stack, TRUE);
+  g_mutex_unlock (&profile_lock);
+}
+
+void
+lgi_profile_enter (lua_State *L, LgiProfileFrame *frame, const gchar *scope,
+		   const gchar *name)
+{
+  ProfileCurrent *current = profile_current_get ();
+  profile_flush (L);
+  frame->scope = current->scope;
+  frame->name = current->name;
+  frame->entered = TRUE;
+  current->scope = scope;
+  current->name = name;
+}
+
+void
+lgi_profile_leave (lua_State *L, LgiProfileFrame *frame)
+{
+  ProfileCurrent *current = profile_current_get ();
+  if (lgi_profile_active)
+    profile_flush (L);
+  current->scope = frame->scope;
+  current->name = frame->name;
+}
+
+static void
+profile_hook (lua_State *L, lua_Debug *ar)
+{
+  (void) ar;
+  if (!lgi_profile_active)
+    lua_sethook (L, NULL, 0, 0);
+  else if (g_atomic_int_get (&profile_pending) > 0)
+    profile_flush (L);
+}
+
+static void
+profile_halt (void)
+{
+  if (profile_thread != NULL)
+    {
+      g_atomic_int_set (&lgi_profile_active, 0);
+      g_thread_join (profile_thread);
+      profile_thread = NULL;
+    }
+}
+
+/* lgi.profile.start { interval = 1000, count = 1000 }, starts
+   sampling every 'interval' microseconds.  Lua code is sampled from
+   the count hook running every 'count' instructions. */
+static int
+profile_start (lua_State *L)
+{
+  lua_Integer interval = 1000, count = 1000;
+  ProfileCurrent *current;
+  if (!lua_isnoneornil (L, 1))
+    {
+      luaL_checktype (L, 1, LUA_TTABLE);
+      lua_getfield (L, 1, "interval");
+      interval = luaL_optinteger (L, -1, interval);
+      lua_getfield (L, 1, "count");
+      count = luaL_optinteger (L, -1, count);
+      lua_pop (L, 2);
+      luaL_argcheck (L, interval > 0 && count > 0, 1,
+		     "interval and count must be positive");
+    }
+
+  profile_halt ();
+  g_mutex_lock (&profile_lock);
+  if (profile_stacks != NULL)
+    g_hash_table_destroy (profile_stacks);
+  profile_stacks = g_hash_table_new_full (g_str_hash, g_str_equal,
+					  g_free, NULL);
+  g_mutex_unlock (&profile_lock);
+
+  g_atomic_int_set (&profile_pending, 0);
+  profile_interval = interval;
+  current = profile_current_get ();
+  current->scope = current->name = NULL;
+  g_atomic_int_set (&lgi_profile_active, 1);
+  profile_thread = g_thread_new ("lgi-profile", profile_sampler, NULL);
+  lua_sethook (L, profile_hook, LUA_MASKCOUNT, count);
+  return 0;
+}
+
+/* lgi.profile.stop([path]), stops sampling and writes collapsed
+   stacks ('frame;frame;... count' lines, as consumed by flamegraph
+   tools) to the file, or returns them as a string when no path is
+   given. */
+static int
+profile_stop (lua_State *L)
+{
+  const gchar *path = luaL_optstring (L, 1, NULL);
+  GHashTableIter iter;
+  gpointer stack, count;
+  GError *err = NULL;
+  GString *out;
+
+  profile_halt ();
+  lua_sethook (L, NULL, 0, 0);
+  profile_flush (L);
+
+  g_mutex_lock (&profile_lock);
+  out = g_string_new (NULL);
+  if (profile_stacks != NULL)
+    {
+      g_hash_table_iter_init (&iter, profile_stacks);
+      while (g_hash_table_iter_next (&iter, &stack, &count))
+	g_string_append_printf (out, "%s %d\n", (const gchar *) stack,
+				GPOINTER_TO_INT (count));
+      g_hash_table_destroy (profile_stacks);
+      profile_stacks = NULL;
+    }
+  g_mutex_unlock (&profile_lock);
+
+  if (path == NULL)
+    {
+      lua_pushlstring (L, out->str, out->len);
+      g_string_free (out, TRUE);
+      return 1;
+    }
+
+  if (!g_file_set_contents (path, out->str, out->len, &err))
+    {
+      g_string_free (out, TRUE);
+      lua_pushnil (L);
+      lua_pushstring (L, err->message);
+      g_error_free (err);
+      return 2;
+    }
+
+  g_string_free (out, TRUE);
+  lua_pushboolean (L, 1);
+  return 1;
+}
+
+static const luaL_Reg profile_reg[] = {
+  { "start", profile_start },
+  { "stop", profile_stop },
+  { NULL, NULL }
+};
+
+void
+lgi_profile_init (lua_State *L)
+{
+  lua_newtable (L);
+  luaL_register (L, NULL, profile_reg);
+  lua_setfield (L, -2, "profile");
+}
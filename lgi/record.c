@@ -422,6 +422,18 @@ static int
 record_gc (lua_State *L)
 {
   Record *record = record_get (L, 1);
+  const gchar *name = "record";
+
+  LGI_PROBE2 (record__gc, record->addr, (int) record->store);
+  if (G_UNLIKELY (lgi_trace_mask & LGI_TRACE_GC))
+    {
+      lua_getfenv (L, 1);
+      lua_getfield (L, -1, "_name");
+      if (lua_type (L, -1) == LUA_TSTRING)
+	name = g_intern_string (lua_tostring (L, -1));
+      lua_pop (L, 2);
+      lgi_trace_event (LGI_TRACE_GC, 'B', NULL, name, NULL);
+    }
 
   if (record->store == RECORD_STORE_EMBEDDED
       || record->store == RECORD_STORE_NESTED)
@@ -445,6 +457,8 @@ record_gc (lua_State *L)
       lua_rawset (L, LUA_REGISTRYINDEX);
     }
 
+  LGI_TRACE (LGI_TRACE_GC, 'E', NULL, name, NULL);
+
   /* Unset the metatable / make the record unusable */
   lua_pushnil (L);
   lua_setmetatable (L, 1);
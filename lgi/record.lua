@@ -79,6 +79,7 @@ function record.struct_mt:_element(instance, symbol)
    if symbol == '_native' then return symbol, '_internal'
    elseif symbol == '_type' then return symbol, '_internal'
    elseif symbol == '_refsink' then return symbol, '_internal'
+   elseif symbol == '_bind' then return symbol, '_internal'
    end
 
    -- If the record has parent struct, try it there.
@@ -151,6 +152,8 @@ function record.struct_mt:_access_internal(instance, element, ...)
       return core.record.query(instance, 'addr')
    elseif element == '_type' then
       return core.record.query(instance, 'repo')
+   elseif element == '_bind' then
+      return component.bind
    end
 end
 
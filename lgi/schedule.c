@@ -0,0 +1,315 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Run queue of coroutines resumed from the GLib mainloop.
+ */
+
+#include "lgi.h"
+
+/* Single queued resume request. */
+typedef struct _ScheduleEntry
+{
+  /* Coroutine to be resumed. */
+  lua_State *co;
+
+  /* Number of resume arguments. */
+  int nargs;
+} ScheduleEntry;
+
+/* Scheduler is GSource which is ready whenever its queue is not
+   empty; all queued coroutines are resumed in its dispatch. */
+typedef struct _Scheduler
+{
+  GSource source;
+
+  /* Thread used for resuming the coroutines and its state lock. */
+  lua_State *L;
+  gpointer state_lock;
+
+  /* Ring buffer of queued entries. */
+  ScheduleEntry *queue;
+  guint head, count, allocated;
+
+  /* Maximal number of coroutines resumed in single dispatch, 0 for
+     unlimited. */
+  guint batch;
+
+  /* Maximal time in microseconds spent by single dispatch, 0 for
+     unlimited. */
+  gint64 budget;
+} Scheduler;
+
+/* Checks whether given coroutine is suspended, i.e. yielded or not
+   started yet. */
+static gboolean
+schedule_is_suspended (lua_State *co)
+{
+  lua_Debug ar;
+  return lua_status (co) == LUA_YIELD
+    || (lua_status (co) == 0 && !lua_getstack (co, 0, &ar)
+	&& lua_gettop (co) > 0);
+}
+
+/* lightuserdata key to registry, containing guard of the scheduler
+   source. */
+static int scheduler;
+
+/* lightuserdata key to registry, containing table which anchors
+   queued coroutines.  It maps lightuserdata(co) -> co, or to
+   { co, args... } when the coroutine was scheduled with arguments.
+   Arguments are moved to the coroutine only when it is resumed,
+   because anything resuming it before would discard them. */
+static int anchors;
+
+static gboolean
+scheduler_prepare (GSource *source, gint *timeout)
+{
+  *timeout = -1;
+  return ((Scheduler *) source)->count > 0;
+}
+
+static gboolean
+scheduler_check (GSource *source)
+{
+  return ((Scheduler *) source)->count > 0;
+}
+
+static gboolean
+scheduler_dispatch (GSource *source, GSourceFunc callback, gpointer data)
+{
+  Scheduler *s = (Scheduler *) source;
+  lua_State *L = s->L;
+  gint64 deadline = 0;
+  guint i, limit;
+  (void) callback;
+  (void) data;
+
+  lgi_state_enter (s->state_lock);
+  luaL_checkstack (L, 4, "");
+
+  /* Coroutines queued during this dispatch are resumed in the next
+     one, so that self-rescheduling coroutine cannot starve the rest
+     of the mainloop. */
+  limit = s->count;
+  if (s->batch > 0 && s->batch < limit)
+    limit = s->batch;
+  if (s->budget > 0)
+    deadline = g_get_monotonic_time () + s->budget;
+
+  lua_pushlightuserdata (L, &anchors);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  for (i = 0; i < limit; i++)
+    {
+      ScheduleEntry entry = s->queue[s->head];
+      int res, arg;
+      s->head = (s->head + 1) % s->allocated;
+      s->count--;
+
+      /* Remove the anchor, but keep the coroutine referenced on our
+	 stack while it runs, it might queue itself again. */
+      lua_pushlightuserdata (L, entry.co);
+      lua_rawget (L, -2);
+      lua_pushlightuserdata (L, entry.co);
+      lua_pushnil (L);
+      lua_rawset (L, -4);
+      if (!schedule_is_suspended (entry.co))
+	{
+	  /* Somebody resumed the coroutine meanwhile, resuming it
+	     again would corrupt it. */
+	  g_warning ("Scheduled coroutine is not suspended any more");
+	  lua_pop (L, 1);
+	  continue;
+	}
+
+      /* Move packed arguments to the coroutine, coroutine without
+	 arguments is anchored directly. */
+      if (entry.nargs > 0)
+	{
+	  luaL_checkstack (L, entry.nargs, "");
+	  luaL_checkstack (entry.co, entry.nargs, "");
+	  for (arg = 2; arg <= entry.nargs + 1; arg++)
+	    lua_rawgeti (L, -1 - (arg - 2), arg);
+	  lua_xmove (L, entry.co, entry.nargs);
+	}
+
+#if LUA_VERSION_NUM >= 502
+      res = lua_resume (entry.co, L, entry.nargs);
+#else
+      res = lua_resume (entry.co, entry.nargs);
+#endif
+      if (res != 0 && res != LUA_YIELD)
+	g_warning ("Error raised in scheduled coroutine: %s",
+		   lua_tostring (entry.co, -1));
+
+      /* Yielded values or results have nobody to be delivered to. */
+      lua_settop (entry.co, 0);
+      lua_pop (L, 1);
+
+      if (deadline != 0 && g_get_monotonic_time () >= deadline)
+	break;
+    }
+
+  lua_pop (L, 1);
+  lgi_state_leave (s->state_lock);
+  return TRUE;
+}
+
+static void
+scheduler_finalize (GSource *source)
+{
+  g_free (((Scheduler *) source)->queue);
+}
+
+static GSourceFuncs scheduler_funcs = {
+  scheduler_prepare,
+  scheduler_check,
+  scheduler_dispatch,
+  scheduler_finalize,
+  NULL,
+  NULL
+};
+
+static void
+scheduler_destroy (gpointer source)
+{
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
+/* Retrieves scheduler of the state, creates and attaches it to the
+   default context when it does not exist yet. */
+static Scheduler *
+scheduler_get (lua_State *L)
+{
+  Scheduler *s;
+  gpointer *guard;
+
+  lua_pushlightuserdata (L, &scheduler);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  guard = lua_touserdata (L, -1);
+  lua_pop (L, 1);
+  if (guard != NULL)
+    return *guard;
+
+  s = (Scheduler *) g_source_new (&scheduler_funcs, sizeof (Scheduler));
+  s->state_lock = lgi_state_get_lock (L);
+  s->queue = NULL;
+  s->head = s->count = s->allocated = 0;
+  s->batch = 0;
+  s->budget = 0;
+
+  /* Create dedicated thread for resuming and anchor it in the
+     registry together with the guard. */
+  lua_pushlightuserdata (L, &scheduler);
+  guard = lgi_guard_create (L, scheduler_destroy);
+  *guard = s;
+  lua_newtable (L);
+  s->L = lua_newthread (L);
+  lua_rawseti (L, -2, 1);
+  lua_setfenv (L, -2);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  g_source_attach (&s->source, NULL);
+  return s;
+}
+
+/* lgi.schedule(co, ...) */
+static int
+schedule_add (lua_State *L)
+{
+  Scheduler *s;
+  lua_State *co = lua_tothread (L, 1);
+  int nargs = lua_gettop (L) - 1;
+  lua_Debug ar;
+  gboolean running;
+  int arg;
+
+  luaL_argcheck (L, co != NULL, 1, "coroutine expected");
+  running = (lua_status (co) == 0 && lua_getstack (co, 0, &ar));
+  luaL_argcheck (L, running || schedule_is_suspended (co), 1,
+		 "cannot schedule dead coroutine");
+
+  lua_pushlightuserdata (L, &anchors);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushlightuserdata (L, co);
+  lua_rawget (L, -2);
+  luaL_argcheck (L, lua_isnil (L, -1), 1, "coroutine is already scheduled");
+  lua_pop (L, 1);
+
+  /* Anchor the coroutine, together with packed arguments if there
+     are any. */
+  lua_pushlightuserdata (L, co);
+  if (nargs == 0)
+    lua_pushvalue (L, 1);
+  else
+    {
+      lua_createtable (L, nargs + 1, 0);
+      for (arg = 1; arg <= nargs + 1; arg++)
+	{
+	  lua_pushvalue (L, arg);
+	  lua_rawseti (L, -2, arg);
+	}
+    }
+  lua_rawset (L, -3);
+
+  /* Append entry to the queue. */
+  s = scheduler_get (L);
+  if (s->count == s->allocated)
+    {
+      guint i, allocated = MAX (16, s->allocated * 2);
+      ScheduleEntry *queue = g_new (ScheduleEntry, allocated);
+      for (i = 0; i < s->count; i++)
+	queue[i] = s->queue[(s->head + i) % s->allocated];
+      g_free (s->queue);
+      s->queue = queue;
+      s->head = 0;
+      s->allocated = allocated;
+    }
+  s->queue[(s->head + s->count) % s->allocated].co = co;
+  s->queue[(s->head + s->count) % s->allocated].nargs = nargs;
+  s->count++;
+  return 0;
+}
+
+/* pending = lgi.schedule_policy { batch = n, budget = ms, priority = p } */
+static int
+schedule_policy (lua_State *L)
+{
+  Scheduler *s = scheduler_get (L);
+  if (!lua_isnoneornil (L, 1))
+    {
+      luaL_checktype (L, 1, LUA_TTABLE);
+      lua_getfield (L, 1, "batch");
+      if (!lua_isnil (L, -1))
+	s->batch = luaL_checkint (L, -1);
+      lua_getfield (L, 1, "budget");
+      if (!lua_isnil (L, -1))
+	s->budget = (gint64) (luaL_checknumber (L, -1) * 1000);
+      lua_getfield (L, 1, "priority");
+      if (!lua_isnil (L, -1))
+	g_source_set_priority (&s->source, luaL_checkint (L, -1));
+      lua_pop (L, 3);
+    }
+
+  lua_pushinteger (L, s->count);
+  return 1;
+}
+
+static const luaL_Reg schedule_reg[] = {
+  { "schedule", schedule_add },
+  { "schedule_policy", schedule_policy },
+  { NULL, NULL }
+};
+
+void
+lgi_schedule_init (lua_State *L)
+{
+  /* Create table anchoring queued coroutines. */
+  lgi_cache_create (L, &anchors, NULL);
+
+  /* Register scheduling API directly into core. */
+  luaL_register (L, NULL, schedule_reg);
+}
@@ -0,0 +1,174 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native sorting of precomputed keys.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "lgi.h"
+
+/* Single precomputed sort key. */
+typedef struct _SortKey
+{
+  /* Original 0-based position of the element. */
+  gint index;
+
+  /* Whether the key is nil; such keys are always sorted last. */
+  gboolean missing;
+
+  /* Numeric key, or collation key of the string key. */
+  gdouble number;
+  gchar *collated;
+} SortKey;
+
+/* Compares two keys, nil keys are always sorted last and equal keys
+   keep their original order. */
+static int
+sort_compare_keys (const SortKey *ka, const SortKey *kb, int sign)
+{
+  int res;
+  if (ka->missing || kb->missing)
+    res = ka->missing - kb->missing;
+  else if (ka->collated != NULL)
+    res = sign * strcmp (ka->collated, kb->collated);
+  else
+    res = sign * ((ka->number > kb->number) - (ka->number < kb->number));
+  return res != 0 ? res : ka->index - kb->index;
+}
+
+static int
+sort_compare (const void *a, const void *b)
+{
+  return sort_compare_keys (a, b, 1);
+}
+
+static int
+sort_compare_desc (const void *a, const void *b)
+{
+  return sort_compare_keys (a, b, -1);
+}
+
+gint *
+lgi_sort_order (lua_State *L, int narg, gint n, gboolean descending)
+{
+  SortKey *keys;
+  gint *order, i;
+  int type = LUA_TNIL;
+
+  /* Keys are kept in userdata, so that they are released when an
+     error is thrown. */
+  lgi_makeabs (L, narg);
+  keys = lua_newuserdata (L, n * sizeof (SortKey) + 1);
+  memset (keys, 0, n * sizeof (SortKey));
+  for (i = 0; i < n; i++)
+    {
+      keys[i].index = i;
+      lua_rawgeti (L, narg, i + 1);
+      if (lua_isnil (L, -1))
+	keys[i].missing = TRUE;
+      else
+	{
+	  if (type == LUA_TNIL)
+	    type = lua_type (L, -1);
+	  if (lua_type (L, -1) != type
+	      || (type != LUA_TNUMBER && type != LUA_TSTRING))
+	    {
+	      while (--i >= 0)
+		g_free (keys[i].collated);
+	      luaL_error (L, "sort: keys must be either all numbers or all"
+			  " strings");
+	    }
+	  if (type == LUA_TNUMBER)
+	    keys[i].number = lua_tonumber (L, -1);
+	  else
+	    keys[i].collated = g_utf8_collate_key (lua_tostring (L, -1), -1);
+	}
+      lua_pop (L, 1);
+    }
+
+  qsort (keys, n, sizeof (SortKey),
+	 descending ? sort_compare_desc : sort_compare);
+
+  order = g_new (gint, n);
+  for (i = 0; i < n; i++)
+    {
+      order[i] = keys[i].index;
+      g_free (keys[i].collated);
+    }
+  lua_pop (L, 1);
+  return order;
+}
+
+/* lgi.sort(array, key[, descending]) */
+static int
+sort_array (lua_State *L)
+{
+  gint i, n, *order;
+  luaL_checktype (L, 1, LUA_TTABLE);
+  luaL_checkany (L, 2);
+  n = lua_objlen (L, 1);
+
+  /* Extract keys, calling key function only once per element. */
+  lua_createtable (L, n, 0);
+  for (i = 1; i <= n; i++)
+    {
+      if (lua_type (L, 2) == LUA_TNUMBER || lua_type (L, 2) == LUA_TSTRING)
+	{
+	  /* Key is name of the field of the element. */
+	  lua_rawgeti (L, 1, i);
+	  if (lua_istable (L, -1) || lua_type (L, -1) == LUA_TUSERDATA)
+	    {
+	      lua_pushvalue (L, 2);
+	      lua_gettable (L, -2);
+	      lua_replace (L, -2);
+	    }
+	  else
+	    {
+	      lua_pop (L, 1);
+	      lua_pushnil (L);
+	    }
+	}
+      else
+	{
+	  lua_pushvalue (L, 2);
+	  lua_rawgeti (L, 1, i);
+	  lua_call (L, 1, 1);
+	}
+      lua_rawseti (L, -2, i);
+    }
+
+  order = lgi_sort_order (L, -1, n, lua_toboolean (L, 3));
+
+  /* Permute the array. */
+  lua_pop (L, 1);
+  lua_createtable (L, n, 0);
+  for (i = 0; i < n; i++)
+    {
+      lua_rawgeti (L, 1, order[i] + 1);
+      lua_rawseti (L, -2, i + 1);
+    }
+  g_free (order);
+  for (i = 1; i <= n; i++)
+    {
+      lua_rawgeti (L, -1, i);
+      lua_rawseti (L, 1, i);
+    }
+  lua_pushvalue (L, 1);
+  return 1;
+}
+
+static const luaL_Reg sort_reg[] = {
+  { "sort", sort_array },
+  { NULL, NULL }
+};
+
+void
+lgi_sort_init (lua_State *L)
+{
+  /* Register sorting API directly into core. */
+  luaL_register (L, NULL, sort_reg);
+}
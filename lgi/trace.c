@@ -0,0 +1,279 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Event trace recorder, exporting Chrome trace JSON.
+ */
+
+#include "lgi.h"
+
+/* Single recorded event.  Strings are never owned by the event, they
+   are either static, come from typelibs or are interned. */
+typedef struct _TraceEvent
+{
+  gint64 ts;
+  const gchar *scope;
+  const gchar *name;
+  const gchar *detail;
+  guint tid;
+  guint8 category;
+  gchar phase;
+} TraceEvent;
+
+volatile gint lgi_trace_mask = 0;
+
+/* Ring buffer of recorded events, protected by the lock. */
+static GMutex trace_lock;
+static TraceEvent *trace_events;
+static gsize trace_capacity, trace_head, trace_count;
+static gint64 trace_start;
+
+/* Small sequential thread ids, as required by trace viewers. */
+static GPrivate trace_tid;
+static gint trace_next_tid;
+
+/* Main context with traced poll function and its original one. */
+static GMainContext *trace_context;
+static GPollFunc trace_poll_func;
+static gboolean trace_dispatching;
+
+static const gchar *trace_categories[] = {
+  "calls", "callbacks", "gc", "mainloop", NULL
+};
+
+void
+lgi_trace_event (gint category, gchar phase, const gchar *scope,
+		 const gchar *name, const gchar *detail)
+{
+  TraceEvent *event;
+  guint tid = GPOINTER_TO_UINT (g_private_get (&trace_tid));
+  if (G_UNLIKELY (tid == 0))
+    {
+      tid = g_atomic_int_add (&trace_next_tid, 1) + 1;
+      g_private_set (&trace_tid, GUINT_TO_POINTER (tid));
+    }
+
+  g_mutex_lock (&trace_lock);
+  if ((lgi_trace_mask & category) != 0)
+    {
+      event = &trace_events[(trace_head + trace_count) % trace_capacity];
+      if (trace_count < trace_capacity)
+	trace_count++;
+      else
+	trace_head = (trace_head + 1) % trace_capacity;
+
+      event->ts = g_get_monotonic_time () - trace_start;
+      event->scope = scope;
+      event->name = name;
+      event->detail = detail;
+      event->tid = tid;
+      event->category = category;
+      event->phase = phase;
+    }
+  g_mutex_unlock (&trace_lock);
+}
+
+/* Poll function installed into the traced main context, records time
+   spent polling and dispatching between the polls. */
+static gint
+trace_poll (GPollFD *ufds, guint nfds, gint timeout)
+{
+  gint res;
+  if (trace_dispatching)
+    LGI_TRACE (LGI_TRACE_MAINLOOP, 'E', "GLib", "dispatch", NULL);
+  LGI_TRACE (LGI_TRACE_MAINLOOP, 'B', "GLib", "poll", NULL);
+  res = trace_poll_func (ufds, nfds, timeout);
+  LGI_TRACE (LGI_TRACE_MAINLOOP, 'E', "GLib", "poll", NULL);
+  LGI_TRACE (LGI_TRACE_MAINLOOP, 'B', "GLib", "dispatch", NULL);
+  trace_dispatching = TRUE;
+  return res;
+}
+
+static void
+trace_unhook_context (void)
+{
+  if (trace_context != NULL)
+    {
+      if (g_main_context_get_poll_func (trace_context) == trace_poll)
+	g_main_context_set_poll_func (trace_context, trace_poll_func);
+      g_main_context_unref (trace_context);
+      trace_context = NULL;
+    }
+}
+
+/* lgi.trace.start { calls = true, callbacks = true, gc = true,
+   mainloop = true, size = 65536 }, starts recording of selected
+   categories of events, discarding previously recorded events.  When
+   no table is given, all categories are recorded. */
+static int
+trace_start_method (lua_State *L)
+{
+  gint mask = 0, i;
+  lua_Integer size = 65536;
+
+  if (lua_isnoneornil (L, 1))
+    mask = LGI_TRACE_CALLS | LGI_TRACE_CALLBACKS | LGI_TRACE_GC
+      | LGI_TRACE_MAINLOOP;
+  else
+    {
+      luaL_checktype (L, 1, LUA_TTABLE);
+      for (i = 0; trace_categories[i] != NULL; i++)
+	{
+	  lua_getfield (L, 1, trace_categories[i]);
+	  if (lua_toboolean (L, -1))
+	    mask |= 1 << i;
+	  lua_pop (L, 1);
+	}
+      lua_getfield (L, 1, "size");
+      if (!lua_isnil (L, -1))
+	size = luaL_checkinteger (L, -1);
+      lua_pop (L, 1);
+      luaL_argcheck (L, size > 0, 1, "size must be positive");
+    }
+
+  g_mutex_lock (&trace_lock);
+  lgi_trace_mask = 0;
+  if ((gsize) size != trace_capacity)
+    {
+      g_free (trace_events);
+      trace_events = g_new (TraceEvent, size);
+      trace_capacity = size;
+    }
+  trace_head = trace_count = 0;
+  trace_start = g_get_monotonic_time ();
+  lgi_trace_mask = mask;
+  g_mutex_unlock (&trace_lock);
+
+  /* Hook into the poll function of the default main context. */
+  trace_unhook_context ();
+  trace_dispatching = FALSE;
+  if (mask & LGI_TRACE_MAINLOOP)
+    {
+      trace_context = g_main_context_ref (g_main_context_default ());
+      trace_poll_func = g_main_context_get_poll_func (trace_context);
+      g_main_context_set_poll_func (trace_context, trace_poll);
+    }
+  return 0;
+}
+
+static void
+trace_append_string (GString *out, const gchar *str)
+{
+  g_string_append_c (out, '"');
+  for (; *str != '\0'; str++)
+    {
+      if (*str == '"' || *str == '\\')
+	g_string_append_c (out, '\\');
+      if ((guchar) *str < 0x20)
+	g_string_append_printf (out, "\\u%04x", *str);
+      else
+	g_string_append_c (out, *str);
+    }
+  g_string_append_c (out, '"');
+}
+
+/* lgi.trace.stop([path]), stops recording and writes recorded events
+   as Chrome trace JSON into the file, or returns it as a string when
+   no path is given. */
+static int
+trace_stop_method (lua_State *L)
+{
+  const gchar *path = luaL_optstring (L, 1, NULL);
+  GError *err = NULL;
+  GString *out;
+  gsize i;
+
+  g_mutex_lock (&trace_lock);
+  lgi_trace_mask = 0;
+  g_mutex_unlock (&trace_lock);
+  trace_unhook_context ();
+
+  out = g_string_sized_new (trace_count * 96 + 32);
+  g_string_append (out, "{\"traceEvents\":[");
+  for (i = 0; i < trace_count; i++)
+    {
+      TraceEvent *event = &trace_events[(trace_head + i) % trace_capacity];
+      gint category = 0;
+      while ((1 << category) != event->category)
+	category++;
+
+      if (i > 0)
+	g_string_append_c (out, ',');
+      g_string_append (out, "\n{\"name\":");
+      if (event->scope != NULL && event->scope[0] != '\0')
+	{
+	  gchar *name = g_strconcat (event->scope, ".", event->name, NULL);
+	  trace_append_string (out, name);
+	  g_free (name);
+	}
+      else
+	trace_append_string (out, event->name);
+      g_string_append_printf (out, ",\"cat\":\"%s\",\"ph\":\"%c\","
+			      "\"ts\":%" G_GINT64_FORMAT ",\"pid\":1,"
+			      "\"tid\":%u", trace_categories[category],
+			      event->phase, event->ts, event->tid);
+      if (event->detail != NULL)
+	{
+	  g_string_append (out, ",\"args\":{\"target\":");
+	  trace_append_string (out, event->detail);
+	  g_string_append_c (out, '}');
+	}
+      g_string_append_c (out, '}');
+    }
+  g_string_append (out, "\n]}\n");
+
+  if (path == NULL)
+    {
+      lua_pushlstring (L, out->str, out->len);
+      g_string_free (out, TRUE);
+      return 1;
+    }
+
+  if (!g_file_set_contents (path, out->str, out->len, &err))
+    {
+      g_string_free (out, TRUE);
+      lua_pushnil (L);
+      lua_pushstring (L, err->message);
+      g_error_free (err);
+      return 2;
+    }
+
+  g_string_free (out, TRUE);
+  lua_pushboolean (L, 1);
+  return 1;
+}
+
+/* Returns name of the target Lua function at the top of the stack in
+   the form 'source:line', interned. */
+const gchar *
+lgi_trace_location (lua_State *L)
+{
+  lua_Debug ar;
+  gchar *location;
+  const gchar *interned;
+
+  lua_pushvalue (L, -1);
+  if (!lua_getinfo (L, ">S", &ar))
+    return NULL;
+
+  location = g_strdup_printf ("%s:%d", ar.short_src, ar.linedefined);
+  interned = g_intern_string (location);
+  g_free (location);
+  return interned;
+}
+
+static const luaL_Reg trace_reg[] = {
+  { "start", trace_start_method },
+  { "stop", trace_stop_method },
+  { NULL, NULL }
+};
+
+void
+lgi_trace_init (lua_State *L)
+{
+  lua_newtable (L);
+  luaL_register (L, NULL, trace_reg);
+  lua_setfield (L, -2, "trace");
+}
@@ -0,0 +1,151 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native accessors of serialized GLib.Variant containers.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+/* Pushes value of the variant, taking over its reference.  Basic
+   types and bytestrings are unpacked directly.  Other variants are
+   pushed as GLib.Variant instances using typetable at 'repotype'
+   index and FALSE is returned, so that the caller can unpack them. */
+static gboolean
+variant_push (lua_State *L, int repotype, GVariant *v)
+{
+  switch (g_variant_classify (v))
+    {
+    case G_VARIANT_CLASS_BOOLEAN:
+      lua_pushboolean (L, g_variant_get_boolean (v));
+      break;
+
+#define H(cls, get)				\
+      case G_VARIANT_CLASS_ ## cls:		\
+	lua_pushnumber (L, get (v));		\
+	break;
+
+      H(BYTE, g_variant_get_byte)
+      H(INT16, g_variant_get_int16)
+      H(UINT16, g_variant_get_uint16)
+      H(INT32, g_variant_get_int32)
+      H(UINT32, g_variant_get_uint32)
+      H(INT64, g_variant_get_int64)
+      H(UINT64, g_variant_get_uint64)
+      H(DOUBLE, g_variant_get_double)
+#undef H
+
+    case G_VARIANT_CLASS_STRING:
+    case G_VARIANT_CLASS_OBJECT_PATH:
+    case G_VARIANT_CLASS_SIGNATURE:
+      {
+	gsize len;
+	const gchar *str = g_variant_get_string (v, &len);
+	lua_pushlstring (L, str, len);
+	break;
+      }
+
+    default:
+      if (g_variant_is_of_type (v, G_VARIANT_TYPE_BYTESTRING))
+	lua_pushstring (L, g_variant_get_bytestring (v));
+      else
+	{
+	  lua_pushvalue (L, repotype);
+	  lgi_record_2lua (L, v, TRUE, 0);
+	  return FALSE;
+	}
+    }
+
+  g_variant_unref (v);
+  return TRUE;
+}
+
+/* Retrieves GVariant instance at narg, expects GLib.Variant typetable
+   at index 1. */
+static GVariant *
+variant_check (lua_State *L, int narg)
+{
+  GVariant *v = NULL;
+  lua_pushvalue (L, 1);
+  lgi_record_2c (L, narg, &v, FALSE, FALSE, FALSE, FALSE);
+  return v;
+}
+
+/* value, unpacked = core.variant.child(Variant, variant, index) */
+static int
+variant_child (lua_State *L)
+{
+  GVariant *v = variant_check (L, 2);
+  lua_Integer index = luaL_checkinteger (L, 3);
+  if (!g_variant_is_container (v) || index < 1
+      || (gsize) index > g_variant_n_children (v))
+    return 0;
+
+  lua_pushboolean (L, variant_push (L, 1, g_variant_get_child_value
+				    (v, index - 1)));
+  return 2;
+}
+
+/* value, unpacked = core.variant.lookup(Variant, dictionary, key)
+   Looks up the key in dictionary with string keys using binary
+   search, entries of the dictionary must be sorted by key. */
+static int
+variant_lookup (lua_State *L)
+{
+  GVariant *v = variant_check (L, 2);
+  const gchar *key = luaL_checkstring (L, 3);
+  const GVariantType *key_type;
+  gsize lo = 0, hi;
+
+  luaL_argcheck (L, g_variant_is_of_type (v, G_VARIANT_TYPE_DICTIONARY), 2,
+		 "dictionary expected");
+  key_type = g_variant_type_key (g_variant_type_element
+				 (g_variant_get_type (v)));
+  luaL_argcheck (L, g_variant_type_equal (key_type, G_VARIANT_TYPE_STRING)
+		 || g_variant_type_equal (key_type,
+					  G_VARIANT_TYPE_OBJECT_PATH)
+		 || g_variant_type_equal (key_type, G_VARIANT_TYPE_SIGNATURE),
+		 2, "dictionary with string keys expected");
+
+  hi = g_variant_n_children (v);
+  while (lo < hi)
+    {
+      gsize mid = lo + (hi - lo) / 2;
+      GVariant *entry = g_variant_get_child_value (v, mid);
+      GVariant *entry_key = g_variant_get_child_value (entry, 0);
+      int cmp = strcmp (key, g_variant_get_string (entry_key, NULL));
+      g_variant_unref (entry_key);
+      if (cmp == 0)
+	{
+	  GVariant *value = g_variant_get_child_value (entry, 1);
+	  g_variant_unref (entry);
+	  lua_pushboolean (L, variant_push (L, 1, value));
+	  return 2;
+	}
+
+      g_variant_unref (entry);
+      if (cmp < 0)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+
+  return 0;
+}
+
+static const luaL_Reg variant_reg[] = {
+  { "child", variant_child },
+  { "lookup", variant_lookup },
+  { NULL, NULL }
+};
+
+void
+lgi_variant_init (lua_State *L)
+{
+  lua_newtable (L);
+  luaL_register (L, NULL, variant_reg);
+  lua_setfield (L, -2, "variant");
+}
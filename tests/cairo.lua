@@ -466,3 +466,142 @@ function cairo.pattern_reference()
    -- use-after-free if custom refsink would not work correctly.
    cr.source = source
 end
+
+function cairo.matrix_transform_points()
+   local cairo = lgi.cairo
+   local bytes = require 'bytes'
+
+   local function compare(a, b)
+      check(math.abs(a-b) < 0.001)
+   end
+
+   local matrix = cairo.Matrix.create_translate(10, 20)
+   matrix:scale(2, 3)
+   local points = { 1, 1, 2, 3 }
+   check(matrix:transform_points(points) == points)
+   compare(points[1], 12)
+   compare(points[2], 23)
+   compare(points[3], 14)
+   compare(points[4], 29)
+
+   matrix:transform_distances(points)
+   compare(points[1], 24)
+   compare(points[2], 69)
+
+   local buffer = bytes.new(2 * 8)
+   check(matrix:transform_points(buffer) == buffer)
+   check(tostring(buffer) ~= ('\0'):rep(2 * 8))
+
+   check(not pcall(matrix.transform_points, matrix, { 1, 2, 3 }))
+   check(not pcall(matrix.transform_points, matrix, { 1, 'x' }))
+   check(not pcall(matrix.transform_points, matrix, bytes.new(2 * 8 + 4)))
+end
+
+function cairo.region_rectangles()
+   local cairo = lgi.cairo
+
+   local region = cairo.Region.from_rectangles { 0, 0, 10, 10,
+						 20, 0, 10, 10 }
+   checkv(region:num_rectangles(), 2, 'number')
+   local rects = region:rectangles()
+   checkv(#rects, 8, 'number')
+   for i = 1, 2 do
+      local rect = region:get_rectangle(i - 1)
+      checkv(rects[4 * i - 3], rect.x, 'number')
+      checkv(rects[4 * i - 2], rect.y, 'number')
+      checkv(rects[4 * i - 1], rect.width, 'number')
+      checkv(rects[4 * i], rect.height, 'number')
+   end
+
+   checkv(#cairo.Region.create():rectangles(), 0, 'number')
+   check(cairo.Region.from_rectangles(rects):equal(region))
+   check(not pcall(cairo.Region.from_rectangles, { 0, 0, 10 }))
+   check(not pcall(cairo.Region.from_rectangles, { 0, 0, 10, {} }))
+end
+
+function cairo.glyph_buffer()
+   local cairo = lgi.cairo
+
+   local glyphs = cairo.GlyphBuffer { 36, 10, 20, 72, 18, 20 }
+   checkv(#glyphs, 2, 'number')
+   local index, x, y = glyphs:get(2)
+   checkv(index, 72, 'number')
+   checkv(x, 18, 'number')
+   checkv(y, 20, 'number')
+   check(glyphs:get(3) == nil)
+   check(not pcall(cairo.GlyphBuffer, { 36, 10 }))
+   check(not pcall(cairo.GlyphBuffer, { 36, 10, false }))
+
+   glyphs:set(3, 40, 26, 20)
+   checkv(#glyphs, 3, 'number')
+   glyphs:translate(5, 1)
+   index, x, y = glyphs:get(3)
+   checkv(index, 40, 'number')
+   checkv(x, 31, 'number')
+   checkv(y, 21, 'number')
+
+   local copy = cairo.GlyphBuffer(2):fill(glyphs, 2)
+   checkv(#copy, 4, 'number')
+   checkv(copy:get(1), 0, 'number')
+   checkv(copy:get(4), 40, 'number')
+   copy:fill(copy, 2)
+   checkv(#copy, 5, 'number')
+   checkv(copy:get(5), 40, 'number')
+   check(not pcall(cairo.GlyphBuffer, -1))
+
+   local surface = cairo.ImageSurface('ARGB32', 100, 100)
+   local cr = cairo.Context(surface)
+   cr:select_font_face('Sans', cairo.FontSlant.NORMAL,
+		       cairo.FontWeight.NORMAL)
+   cr:show_glyphs(glyphs)
+   cr:show_glyphs { 36, 10, 50 }
+   cr:glyph_path(glyphs)
+   check(cr:has_current_point())
+   check(cr:glyph_extents(glyphs).x_advance > 0)
+   check(cr.scaled_font:glyph_extents(glyphs).x_advance > 0)
+end
+
+function cairo.draw_cached()
+   local cairo = lgi.cairo
+
+   local calls = 0
+   local function draw(cr, width, height)
+      calls = calls + 1
+      cr:set_source_rgb(1, 0, 0)
+      cr:rectangle(0, 0, width, height)
+      cr:fill()
+   end
+
+   local surface = cairo.ImageSurface('ARGB32', 100, 100)
+   local cr = cairo.Context(surface)
+   local recording = cairo.cached('test.square', 10, 10, draw)
+   check(cairo.RecordingSurface:is_type_of(recording))
+   check(cairo.cached('test.square', 10, 10, draw) == recording)
+   cr:paint_cached('test.square', 10, 10, draw, 20, 20)
+   checkv(calls, 1, 'number')
+   cr:paint_cached('test.square', 20, 10, draw)
+   checkv(calls, 2, 'number')
+
+   cairo.cached_flush('test.square')
+   cairo.cached('test.square', 10, 10, draw)
+   checkv(calls, 3, 'number')
+
+   local budget = cairo.cached_budget(4 * 10 * 10)
+   cairo.cached('test.other', 10, 10, draw)
+   cairo.cached('test.square', 10, 10, draw)
+   checkv(calls, 5, 'number')
+
+   -- Least recently used entry is evicted first.
+   cairo.cached_budget(2 * 4 * 10 * 10)
+   cairo.cached('test.a', 10, 10, draw)
+   cairo.cached('test.b', 10, 10, draw)
+   cairo.cached('test.a', 10, 10, draw)
+   cairo.cached('test.c', 10, 10, draw)
+   checkv(calls, 8, 'number')
+   cairo.cached('test.a', 10, 10, draw)
+   checkv(calls, 8, 'number')
+   cairo.cached('test.b', 10, 10, draw)
+   checkv(calls, 9, 'number')
+   cairo.cached_budget(budget)
+   cairo.cached_flush()
+end
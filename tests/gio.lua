@@ -8,7 +8,7 @@
 
 --]]--------------------------------------------------------------------------
 
-local type = type
+local type, select, pcall = type, select, pcall
 
 local lgi = require 'lgi'
 local core = require 'lgi.core'
@@ -78,3 +78,160 @@ function gio.async_access()
    check(Gio.DBusProxy:is_type_of(proxy))
 end
 
+
+function gio.async_call_sync()
+   local Gio = lgi.Gio
+   local a, b, c, n = Gio.Async.call(function(...)
+	 return 1, nil, 3, select('#', ...)
+   end)(nil, nil)
+   checkv(a, 1, 'number')
+   checkv(b, nil, 'nil')
+   checkv(c, 3, 'number')
+   checkv(n, 2, 'number')
+
+   local call = Gio.Async.call(function(x) return x * 2 end)
+   for i = 1, 100 do checkv(call(i), i * 2, 'number') end
+
+   check(not pcall(Gio.Async.call(function() error('failed') end)))
+end
+
+function gio.async_call_error()
+   local Gio = lgi.Gio
+   local file = Gio.File.new_for_path('.')
+   local ok, err = pcall(Gio.Async.call(function()
+      check(file:async_query_info('standard::size', 'NONE') ~= nil)
+      error('failed after wait', 0)
+   end))
+   check(not ok)
+   checkv(err, 'failed after wait', 'string')
+end
+
+function gio.next_batch()
+   local GLib, Gio = lgi.GLib, lgi.Gio
+   local dir = Gio.File.new_for_path('.')
+   local attrs = { 'standard::name', 'standard::type', 'standard::size' }
+
+   local count = 0
+   local enum = dir:enumerate_children(table.concat(attrs, ','), 'NONE')
+   while true do
+      local batch = enum:next_batch(16, attrs)
+      check(type(batch) == 'table')
+      if #batch == 0 then break end
+      for i = 1, #batch do
+	 local info = batch[i]
+	 checkv(info['standard::name'], info['standard::name'], 'string')
+	 checkv(info['standard::size'], info['standard::size'], 'number')
+	 check(type(info['standard::type']) == 'number')
+	 count = count + 1
+      end
+   end
+   enum:close()
+   check(count > 0)
+
+   local async_count = Gio.Async.call(function()
+	 local n = 0
+	 local enum = dir:async_enumerate_children(
+	    table.concat(attrs, ','), 'NONE')
+	 while true do
+	    local batch = enum:async_next_batch(16, attrs)
+	    if #batch == 0 then break end
+	    n = n + #batch
+	 end
+	 enum:async_close()
+	 return n
+   end)()
+   checkv(async_count, count, 'number')
+
+   enum = dir:enumerate_children('standard::name', 'NONE')
+   check(not pcall(enum.next_batch, enum, -1, { 'standard::name' }))
+   local ok, err = pcall(Gio.Async.call(function()
+      local enum = dir:async_enumerate_children('standard::name', 'NONE')
+      enum:async_next_batch(16, { 'standard::name' })
+      error('failed after batch', 0)
+   end))
+   check(not ok)
+   checkv(err, 'failed after batch', 'string')
+end
+
+function gio.buffered_streams()
+    local Gio = lgi.Gio
+
+    local Source = Gio.InputStream:derive_buffered('LgiTestSource', 4)
+    local fills = 0
+    function Source:do_fill(buffer)
+	fills = fills + 1
+	if fills == 1 then
+	    buffer[1], buffer[2], buffer[3], buffer[4] = 97, 98, 10, 99
+	    return 4
+	elseif fills == 2 then
+	    return 'd\n'
+	end
+	return 0
+    end
+    local input = Gio.DataInputStream.new(Source())
+    checkv(input:read_line(), 'ab', 'string')
+    checkv(input:read_line(), 'cd', 'string')
+    check(input:read_line() == nil)
+
+    local Sink = Gio.OutputStream:derive_buffered('LgiTestSink', 4)
+    local drained = {}
+    function Sink:do_drain(data)
+	drained[#drained + 1] = data
+	return true
+    end
+    local output = Sink()
+    for _, piece in ipairs { 'a', 'bc', 'def', 'g' } do
+	check(output:write_all(piece))
+    end
+    checkv(table.concat(drained, ','), 'abcd', 'string')
+    check(output:close())
+    checkv(table.concat(drained, ','), 'abcd,efg', 'string')
+
+    local Failing = Gio.InputStream:derive_buffered('LgiTestFailing')
+    function Failing:do_fill(buffer)
+	return nil, 'broken'
+    end
+    local ok, err = Failing():read_bytes(10)
+    check(not ok and err.message:match('broken'))
+end
+
+function gio.value_list_model()
+    local Gio = lgi.Gio
+    if not Gio.ValueListModel then return end
+
+    local model = Gio.ValueListModel.new { 'a', 'b', 'c' }
+    checkv(model:get_n_items(), 3, 'number')
+    checkv(model:get_item(1):get_value(), 'b', 'string')
+    check(model:get_item(1) == model:get_item(1))
+    check(model:get_item(3) == nil)
+
+    local changes = {}
+    function model:on_items_changed(position, removed, added)
+	changes[#changes + 1] = ('%d:%d:%d'):format(position, removed, added)
+    end
+    model:splice(1, 1, { 'x', 'y', 'z' })
+    model:replace(0, { 'q' })
+    model:splice(2, 3, {})
+    checkv(table.concat(changes, ','), '1:1:3,0:1:1,2:3:0', 'string')
+    checkv(model:get_n_items(), 2, 'number')
+    checkv(model:get_value(0), 'q', 'string')
+    checkv(model:get_item(1):get_value(), 'x', 'string')
+
+    local wrapped = 0
+    local custom = Gio.ValueListModel.new({ 1, 2, 3 }, function(value)
+	wrapped = wrapped + 1
+	return Gio.SimpleAction { name = 'action' .. value }
+    end, Gio.SimpleAction, 1)
+    check(custom:get_item_type() == Gio.SimpleAction._gtype)
+    checkv(custom:get_item(2).name, 'action3', 'string')
+    checkv(custom:get_item(2).name, 'action3', 'string')
+    checkv(wrapped, 1, 'number')
+    custom:get_item(0)
+    custom:get_item(2)
+    checkv(wrapped, 3, 'number')
+
+    local mistyped = Gio.ValueListModel.new({ 1 }, function()
+	return Gio.Cancellable()
+    end, Gio.SimpleAction)
+    check(mistyped:get_item(0) == nil)
+end
@@ -134,6 +134,187 @@ function glib.gsourcefuncs()
    check(called == source)
 end
 
+function glib.mainctx_poller()
+   local GLib = lgi.GLib
+
+   local context = GLib.MainContext.default()
+   local poller = context:poller()
+   local fired = 0
+   GLib.idle_add(GLib.PRIORITY_DEFAULT, function()
+      fired = fired + 1
+      return fired < 3
+   end)
+
+   for _ = 1, 3 do
+      local ready = poller:prepare()
+      local n_fds, timeout = poller:query()
+      check(type(n_fds) == 'number' and type(timeout) == 'number')
+      for i = 1, n_fds do
+	 local fd, events = poller:fd(i)
+	 check(type(fd) == 'number' and type(events) == 'number')
+      end
+      check(poller:check())
+      poller:dispatch()
+   end
+   check(fired == 3)
+
+   -- Idle source is gone, further iterations must not invoke it.
+   poller:prepare()
+   poller:query()
+   if poller:check() then poller:dispatch() end
+   check(fired == 3)
+
+   local epfd = poller:epoll()
+   check(epfd == nil or type(epfd) == 'number')
+end
+
+function glib.schedule()
+   local GLib = lgi.GLib
+   local loop = GLib.MainLoop()
+   local log = {}
+
+   local function worker(name)
+      return coroutine.create(function(...)
+	 log[#log + 1] = name .. ':' .. table.concat({...}, ',')
+	 for i = 1, 3 do
+	    lgi.schedule(coroutine.running(), i)
+	    local value = coroutine.yield()
+	    log[#log + 1] = name .. value
+	 end
+      end)
+   end
+
+   lgi.schedule(worker('a'), 1, 2)
+   lgi.schedule(worker('b'))
+   check(not pcall(lgi.schedule, 42))
+   check(lgi.schedule_policy() == 2)
+
+   GLib.timeout_add(GLib.PRIORITY_DEFAULT, 100, function() loop:quit() end)
+   loop:run()
+
+   -- Coroutines are interleaved, because self-scheduled coroutine is
+   -- resumed only in the next dispatch.
+   check(table.concat(log, ' ') == 'a:1,2 b: a1 b1 a2 b2 a3 b3')
+   check(lgi.schedule_policy() == 0)
+
+   -- Scheduled arguments survive foreign resume of the coroutine.
+   local values = {}
+   local co = coroutine.create(function()
+      while true do values[#values + 1] = coroutine.yield() end
+   end)
+   coroutine.resume(co)
+   lgi.schedule(co, 'scheduled')
+   coroutine.resume(co, 'foreign')
+   GLib.timeout_add(GLib.PRIORITY_DEFAULT, 100, function() loop:quit() end)
+   loop:run()
+   check(table.concat(values, ' ') == 'foreign scheduled')
+end
+
+function glib.sort()
+   local lgi = require 'lgi'
+   local items = { { n = 3, s = 'b' }, { n = 1, s = 'c' }, { n = 2, s = 'a' },
+		   { n = 1, s = 'd' } }
+   check(lgi.sort(items, 'n') == items)
+   check(items[1].s == 'c' and items[2].s == 'd' and items[3].s == 'a'
+	 and items[4].s == 'b')
+   lgi.sort(items, 's', true)
+   check(items[1].s == 'd' and items[4].s == 'a')
+   local calls = 0
+   lgi.sort(items, function(item) calls = calls + 1 return -item.n end)
+   check(calls == 4)
+   check(items[1].n == 3 and items[4].n == 1)
+   check(not pcall(lgi.sort, { 1, 'a' }, function(item) return item end))
+end
+
+function glib.mapped_file_view()
+   local GLib = lgi.GLib
+   local path = GLib.build_filenamev { GLib.get_tmp_dir(), 'lgi-view-test' }
+   check(GLib.file_set_contents(path, 'head\1\0\0\0\0\2tail'))
+   local view = GLib.MappedFile.new(path, false):view()
+   collectgarbage()
+   collectgarbage()
+   check(#view == 14)
+   check(view[1] == 104 and view[15] == nil)
+   check(view:read('uint32', 5) == 1)
+   check(view:read('uint16', 9, true) == 2)
+   check(not pcall(view.read, view, 'uint32', 12))
+   local tail = view:sub(-4)
+   check(tostring(tail) == 'tail')
+   check(view:find('tail') == 11)
+   check(view:find('tail', 12) == nil)
+   check(tostring(view:sub(3, 2)) == '')
+   local bytes = tail:bytes()
+   check(#bytes == 4 and bytes.data == 'tail')
+   check(GLib.Variant.new_from_view('ay', tail).value == 'tail')
+   os.remove(path)
+end
+
+function glib.string_length()
+   local GLib = lgi.GLib
+   checkv(GLib.markup_escape_text('a<b>'), 'a&lt;b&gt;', 'string')
+   checkv(GLib.markup_escape_text('a<b>', 2), 'a&lt;', 'string')
+   checkv(GLib.markup_escape_text('a<b>', -1), 'a&lt;b&gt;', 'string')
+
+   local keyfile = GLib.KeyFile()
+   keyfile:set_string('group', 'key', 'value')
+   local data, length = keyfile:to_data()
+   checkv(#data, length, 'number')
+
+   checkv(GLib.path_get_basename('/tmp/lgi-test.txt'), 'lgi-test.txt',
+	  'string')
+end
+
+function glib.trace()
+   local GLib = lgi.GLib
+   lgi.trace.start { calls = true, callbacks = true, gc = true }
+   GLib.get_monotonic_time()
+   local fired = false
+   GLib.idle_add(GLib.PRIORITY_DEFAULT, function()
+      fired = true
+      return false
+   end)
+   local context = GLib.MainContext.default()
+   while not fired do context:iteration(true) end
+   collectgarbage()
+   local json = lgi.trace.stop()
+   check(json:match('^{"traceEvents":%['))
+   check(json:find('"name":"GLib.get_monotonic_time","cat":"calls","ph":"B"',
+		   1, true))
+   check(json:find('"name":"GLib.get_monotonic_time","cat":"calls","ph":"E"',
+		   1, true))
+   check(json:find('"cat":"callbacks","ph":"B"', 1, true))
+   check(json:find('"target":"', 1, true))
+
+   -- Nothing is recorded after stopping.
+   GLib.get_monotonic_time()
+   lgi.trace.start { calls = false }
+   GLib.get_monotonic_time()
+   check(not lgi.trace.stop():find('get_monotonic_time', 1, true))
+end
+
+function glib.profile()
+   local GLib = lgi.GLib
+   lgi.profile.start { interval = 100, count = 100 }
+   GLib.usleep(20000)
+   check(not pcall(GLib.random_int_range, 'bad'))
+   local timer, sum = GLib.Timer(), 0
+   while timer:elapsed() < 0.02 do
+      for i = 1, 1000 do sum = sum + i end
+   end
+   local stacks = lgi.profile.stop()
+   local native, lua = 0, 0
+   for stack, count in stacks:gmatch('([^\n]*) (%d+)\n') do
+      check(not stack:match('GLib%.random_int_range$'))
+      if stack:match(';GLib%.usleep$') then
+	 native = native + count
+      elseif stack:match('glib%.lua:%d+') then
+	 lua = lua + count
+      end
+   end
+   check(native > 0)
+   check(lua > 0)
+end
+
 function glib.coroutine_related_crash()
     -- This test does not have a specific assert() or check() call. Instead it
     -- is a regression test: Once upon a time this caused a segmentation fault
@@ -64,6 +64,34 @@ function gobject.native()
    check(GObject.Object(p) == o)
 end
 
+function gobject.bind()
+   local Gio = lgi.Gio
+   local c = Gio.Cancellable()
+   local is_cancelled = c:_bind('is_cancelled')
+   local cancel = core.callable.bind(Gio.Cancellable.cancel, c)
+   check(is_cancelled() == false)
+   cancel()
+   check(is_cancelled() == true)
+   check(not pcall(core.callable.bind, Gio.Cancellable.cancel,
+		   lgi.GObject.Object()))
+   check(not pcall(core.callable.bind, Gio.Cancellable.new, c))
+end
+
+function gobject.call_void()
+   local GLib, Gio = lgi.GLib, lgi.Gio
+   local c = Gio.Cancellable()
+   checkv(select('#', Gio.Cancellable.is_cancelled:call_void(c)), 0,
+	  'number')
+   checkv(select('#', GLib.strdup:call_void('owned')), 0, 'number')
+   local cancel = c:_bind('cancel')
+   cancel:call_void()
+   check(c:is_cancelled())
+
+   local file = Gio.File.new_for_path('/nonexistent/lgi/file')
+   local ok, err = Gio.File.load_contents:call_void(file)
+   check(ok == false and GLib.Error:is_type_of(err))
+end
+
 function gobject.gtype_create()
    local GObject = lgi.GObject
    local Gio = lgi.Gio
@@ -350,3 +378,111 @@ function gobject.signal_query()
    check(#query.param_types == 1)
    check(query.param_types[1] == GObject.Type.name(GObject.Type.PARAM))
 end
+
+function gobject.property_column()
+   local GLib, GObject, Gio = lgi.GLib, lgi.GObject, lgi.Gio
+   local actions = {}
+   for i = 1, 5 do
+      actions[i] = Gio.SimpleAction.new_stateful(
+	 'action' .. i, nil, GLib.Variant('i', i))
+   end
+   local names = GObject.Object.get_property_column(actions, 'name')
+   check(#names == 5 and names[1] == 'action1' and names[5] == 'action5')
+   GObject.Object.set_property_column(actions, 'enabled', false)
+   check(not actions[3].enabled)
+   GObject.Object.set_property_column(actions, 'enabled',
+				      { true, false, true, false, true })
+   local enabled = GObject.Object.get_property_column(actions, 'enabled')
+   check(enabled[1] == true and enabled[2] == false and enabled[5] == true)
+   local states = GObject.Object.get_property_column(actions, 'state')
+   check(states[4].value == 4)
+   check(not pcall(GObject.Object.get_property_column, actions, 'missing'))
+   check(not pcall(GObject.Object.set_property_column, actions, 'name', 'x'))
+end
+
+function gobject.subclass_prop_native()
+   local GObject = lgi.GObject
+   local Derived = GObject.Object:derive('LgiTestDerivedPropNative')
+   Derived._property.counter = GObject.ParamSpecInt(
+      'counter', 'Nick counter', 'Blurb counter', 0, 100, 42,
+      { 'READABLE', 'WRITABLE' })
+   Derived._property.label = GObject.ParamSpecString(
+      'label', 'Nick label', 'Blurb label', 'default',
+      { 'READABLE', 'WRITABLE' })
+   Derived._property.mirrored = GObject.ParamSpecString(
+      'mirrored', 'Nick mirrored', 'Blurb mirrored', nil,
+      { 'READABLE', 'WRITABLE' })
+   Derived._property_native.counter = true
+   Derived._property_native.label = true
+
+   local der = Derived()
+   checkv(der.counter, 42, 'number')
+   checkv(der.label, 'default', 'string')
+   local notified = 0
+   der.on_notify['counter'] = function() notified = notified + 1 end
+   der.counter = 7
+   der.label = 'assign'
+   der.mirrored = 'mirror'
+   checkv(der.counter, 7, 'number')
+   checkv(der.label, 'assign', 'string')
+   checkv(notified, 1, 'number')
+   check(der.priv.counter == nil)
+   checkv(der.priv.mirrored, 'mirror', 'string')
+   checkv(Derived().counter, 42, 'number')
+end
+
+function gobject.bind_transform()
+   local GObject = lgi.GObject
+   local Model = GObject.Object:derive('LgiTestBindTransformModel')
+   Model._property.value = GObject.ParamSpecInt(
+      'value', 'Value', 'Value', -1000, 1000, 0,
+      { 'READABLE', 'WRITABLE' })
+   Model._property.flag = GObject.ParamSpecBoolean(
+      'flag', 'Flag', 'Flag', false, { 'READABLE', 'WRITABLE' })
+   Model._property.text = GObject.ParamSpecString(
+      'text', 'Text', 'Text', nil, { 'READABLE', 'WRITABLE' })
+   Model._property.number = GObject.ParamSpecDouble(
+      'number', 'Number', 'Number', -1000, 1000, 0,
+      { 'READABLE', 'WRITABLE' })
+
+   local source, target = Model(), Model()
+   local binding = source:bind_property_transform(
+      'flag', target, 'flag', { 'SYNC_CREATE', 'BIDIRECTIONAL' },
+      { 'invert' })
+   check(target.flag == true)
+   source.flag = true
+   check(target.flag == false)
+   target.flag = true
+   check(source.flag == false)
+   binding:unbind()
+
+   local targets = { Model(), Model(), Model(), Model() }
+   local bindings = GObject.Object.bind_properties {
+      { source, 'value', targets[1], 'number', 'SYNC_CREATE',
+	{ 'scale', 0.5, 1 } },
+      { source, 'value', targets[2], 'value', 'SYNC_CREATE',
+	{ 'clamp', 0, 10 } },
+      { source, 'value', targets[3], 'text', 'SYNC_CREATE',
+	{ 'format', '%d items' } },
+      { source, 'value', targets[4], 'flag', 'SYNC_CREATE',
+	{ 'threshold', 5 } },
+      { source, 'value', targets[4], 'text', 'SYNC_CREATE',
+	{ 'map', { [1] = 'one', [2] = 'two' }, 'many' } },
+   }
+   check(#bindings == 5)
+   source.value = 20
+   checkv(targets[1].number, 11, 'number')
+   checkv(targets[2].value, 10, 'number')
+   checkv(targets[3].text, '20 items', 'string')
+   check(targets[4].flag == true)
+   checkv(targets[4].text, 'many', 'string')
+   source.value = 2
+   checkv(targets[2].value, 2, 'number')
+   check(targets[4].flag == false)
+   checkv(targets[4].text, 'two', 'string')
+
+   check(not pcall(source.bind_property_transform, source, 'value',
+		   target, 'text', 'BIDIRECTIONAL', { 'format', '%d' }))
+   check(not pcall(source.bind_property_transform, source, 'value',
+		   target, 'text', nil, { 'unknown' }))
+end
@@ -238,6 +238,31 @@ function gtk.text_tag_table_tag()
    check(t.tag.notexist == nil)
 end
 
+function gtk.text_buffer_runs()
+   local Gtk = lgi.Gtk
+   local bold = Gtk.TextTag { name = 'bold' }
+   local buffer = Gtk.TextBuffer {
+      tag_table = Gtk.TextTagTable { bold, Gtk.TextTag { name = 'red' } } }
+   checkv(buffer:insert_runs { { 'hello ', bold }, 'big ', { 'world', 'red',
+							      'bold' } },
+	  15, 'number')
+   checkv(buffer.text, 'hello big world', 'string')
+   check(buffer:get_iter_at_offset(0):has_tag(bold))
+   check(not buffer:get_iter_at_offset(7):has_tag(bold))
+   check(buffer:get_iter_at_offset(12):has_tag(buffer.tag_table.tag.red))
+   checkv(buffer:insert_runs({ 'X' }, 0), 1, 'number')
+   checkv(buffer.text, 'Xhello big world', 'string')
+   check(not pcall(buffer.insert_runs, buffer, { { 'a', 'nonexistent' } }))
+   check(not pcall(buffer.insert_runs, buffer, { 'ok', { 42 } }))
+   checkv(buffer.text, 'Xhello big world', 'string')
+
+   buffer:apply_tag_ranges('red', { 0, 1, 7, 10 })
+   local red = buffer.tag_table.tag.red
+   check(buffer:get_iter_at_offset(0):has_tag(red))
+   check(not buffer:get_iter_at_offset(3):has_tag(red))
+   check(buffer:get_iter_at_offset(8):has_tag(red))
+end
+
 function gtk.liststore()
    local Gtk = lgi.Gtk
    local GObject = lgi.GObject
@@ -329,6 +354,34 @@ function gtk.treemodel_pairs()
    check(count == 0)
 end
 
+function gtk.store_sort_by()
+   local Gtk = lgi.Gtk
+   local GObject = lgi.GObject
+   local store = Gtk.ListStore.new { GObject.Type.INT, GObject.Type.STRING }
+   for i, name in ipairs { 'delta', 'alpha', 'charlie', 'bravo' } do
+      store:append { i, name }
+   end
+   local function column(col)
+      local values = {}
+      for _, row in store:pairs() do values[#values + 1] = row[col] end
+      return table.concat(values, ' ')
+   end
+   store:sort_by(2)
+   checkv(column(2), 'alpha bravo charlie delta', 'string')
+   store:sort_by(1, true)
+   checkv(column(1), '4 3 2 1', 'string')
+   store:sort_by(function(model, iter) return #model[iter][2] end)
+   checkv(column(2), 'bravo alpha delta charlie', 'string')
+
+   local tree = Gtk.TreeStore.new { GObject.Type.INT }
+   local parent = tree:append(nil, { 0 })
+   for _, n in ipairs { 3, 1, 2 } do tree:append(parent, { n }) end
+   tree:sort_by(1, false, parent)
+   local values = {}
+   for _, row in tree:pairs(parent) do values[#values + 1] = row[1] end
+   checkv(table.concat(values, ' '), '1 2 3', 'string')
+end
+
 function gtk.treeview()
    local Gtk = lgi.Gtk
    local GObject = lgi.GObject
@@ -357,6 +410,44 @@ function gtk.treeview()
    check(view.child.renderer == renderer)
 end
 
+function gtk.treeview_map_attributes()
+   local Gtk = lgi.Gtk
+   local GObject = lgi.GObject
+   local store = Gtk.ListStore.new {
+      GObject.Type.STRING, GObject.Type.INT, GObject.Type.DOUBLE,
+      GObject.Type.BOOLEAN }
+   local renderer = Gtk.CellRendererText()
+   local column = Gtk.TreeViewColumn { { renderer } }
+   column:map_attributes {
+      renderer, {
+	 text = 1,
+	 foreground = { col = 2, map = { [1] = 'red', [2] = 'green' },
+			default = 'black' },
+	 visible = { col = 4, map = { [false] = false }, default = true },
+	 placeholder_text = { col = 3, format = '%.2f s' },
+      }
+   }
+   check(not pcall(column.map_attributes, column,
+		   { renderer, { text = { col = 3, format = '%s' } } }))
+   check(not pcall(column.map_attributes, column,
+		   { renderer, { nonexistent = { col = 1 } } }))
+
+   local function render(values)
+      local iter = store:append(values)
+      column:cell_set_cell_data(store, iter, false, false)
+   end
+   render { 'first', 1, 1.5, true }
+   checkv(renderer.text, 'first', 'string')
+   checkv(renderer.foreground_rgba.red, 1, 'number')
+   checkv(renderer.visible, true, 'boolean')
+   checkv(renderer.placeholder_text, '1.50 s', 'string')
+   render { 'second', 3, 2, false }
+   checkv(renderer.text, 'second', 'string')
+   checkv(renderer.foreground_rgba.red, 0, 'number')
+   checkv(renderer.visible, false, 'boolean')
+   checkv(renderer.placeholder_text, '2.00 s', 'string')
+end
+
 function gtk.actiongroup_add()
    local Gtk = lgi.Gtk
    -- Adding normal action and action with an accelerator.
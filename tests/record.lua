@@ -23,3 +23,11 @@ function record.native()
    check(type(p) == 'userdata')
    check(GObject.EnumValue(p) == c)
 end
+
+function record.bind()
+   local sum = GLib.Checksum(GLib.ChecksumType.MD5)
+   local update = sum:_bind('update')
+   for _ = 1, 3 do update('abc') end
+   check(sum:get_string() == GLib.compute_checksum_for_string(
+	    GLib.ChecksumType.MD5, 'abcabcabc'))
+end
@@ -0,0 +1,174 @@
+------------------------------------------------------------------------------
+--
+--  LGI end-to-end scenario benchmarks
+--
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+-- Headless workloads modeled on the samples directory.  Every
+-- scenario performs fixed amount of work and reports throughput and
+-- 99th percentile latency of its operations.  Scenarios whose
+-- libraries are not available are skipped.  Scenario names can be
+-- given on the commandline to run only selected ones.
+
+local lgi = require 'lgi'
+local GLib = lgi.GLib
+local Gio = lgi.Gio
+
+local scenarios = {}
+
+-- Collects latencies of individual operations.
+local function recorder()
+   local samples, last = {}, GLib.get_monotonic_time()
+   return {
+      start = function() last = GLib.get_monotonic_time() end,
+      mark = function()
+	 local now = GLib.get_monotonic_time()
+	 samples[#samples + 1] = now - last
+	 last = now
+      end,
+      samples = samples,
+   }
+end
+
+local function report(name, count, unit, amount, elapsed, samples)
+   table.sort(samples)
+   local p99 = samples[math.max(1, math.ceil(#samples * 0.99))] or 0
+   print(('%-8s %8d ops %12.1f %s/s   p99 %8.3f ms'):format(
+	    name, count, amount / elapsed, unit, p99 / 1000))
+end
+
+-- Local HTTP request throughput with loopback client, after
+-- samples/soupsvr.lua.
+scenarios[#scenarios + 1] = { 'http', function()
+   local ok, Soup = pcall(lgi.require, 'Soup', '3.0')
+   if not ok then return 'Soup-3.0 not available' end
+
+   local payload = ('x'):rep(16 * 1024)
+   local server = Soup.Server {}
+   server:add_handler('/', function(server, msg)
+      msg:set_status(200, nil)
+      msg:set_response('application/octet-stream', 'COPY', payload)
+   end)
+   assert(server:listen_local(0, 0))
+   local uri = server:get_uris()[1]:to_string()
+
+   local count, rec = 2000, recorder()
+   local session = Soup.Session()
+   local timer = GLib.Timer()
+
+   -- Gio.Async.call spins the context until the requests finish and
+   -- rethrows their errors.
+   Gio.Async.call(function()
+      rec.start()
+      for _ = 1, count do
+	 local body = session:async_send_and_read(Soup.Message.new('GET', uri))
+	 assert(body and body:get_size() == #payload)
+	 rec.mark()
+      end
+   end)()
+   server:disconnect()
+   report('http', count, 'req', count, timer:elapsed(), rec.samples)
+end }
+
+-- Stream copy throughput, after samples/giostream.lua.
+scenarios[#scenarios + 1] = { 'stream', function()
+   local chunk, size = 64 * 1024, 32 * 1024 * 1024
+   local source = Gio.File.new_for_path(
+      GLib.build_filenamev { GLib.get_tmp_dir(), 'lgi-bench-source' })
+   local target = Gio.File.new_for_path(
+      GLib.build_filenamev { GLib.get_tmp_dir(), 'lgi-bench-target' })
+   local block = GLib.Bytes(('0123456789abcdef'):rep(chunk / 16))
+   local output = assert(source:replace(nil, false, 'NONE'))
+   for _ = 1, size / chunk do assert(output:write_bytes(block)) end
+   assert(output:close())
+
+   local rec, count = recorder(), 0
+   local timer = GLib.Timer()
+   local input = assert(source:read())
+   output = assert(target:replace(nil, false, 'NONE'))
+   rec.start()
+   while true do
+      local bytes = assert(input:read_bytes(chunk))
+      if bytes:get_size() == 0 then break end
+      assert(output:write_bytes(bytes))
+      count = count + 1
+      rec.mark()
+   end
+   assert(input:close())
+   assert(output:close())
+   report('stream', count, 'MB', size / (1024 * 1024), timer:elapsed(),
+	  rec.samples)
+   source:delete()
+   target:delete()
+end }
+
+-- Offscreen rendering, after samples/cairo.lua.
+scenarios[#scenarios + 1] = { 'cairo', function()
+   local cairo = lgi.cairo
+   local surface = cairo.ImageSurface('ARGB32', 512, 512)
+   local cr = cairo.Context(surface)
+   local count, rec = 500, recorder()
+   local timer = GLib.Timer()
+   rec.start()
+   for frame = 1, count do
+      cr:set_source_rgb(1, 1, 1)
+      cr:paint()
+      for i = 0, 99 do
+	 local x, y = (i % 10) * 50 + 25, math.floor(i / 10) * 50 + 25
+	 cr:set_source_rgba(i / 100, frame / count, 0.5, 0.8)
+	 cr:arc(x, y, 20, 0, 2 * math.pi)
+	 cr:fill()
+	 cr:rectangle(x - 10, y - 10, 20, 20)
+	 cr:stroke()
+      end
+      cr:move_to(10, 500)
+      cr:set_source_rgb(0, 0, 0)
+      cr:show_text(('frame %d'):format(frame))
+      surface:flush()
+      rec.mark()
+   end
+   report('cairo', count, 'frame', count, timer:elapsed(), rec.samples)
+end }
+
+-- Buffer rate of fakesrc -> fakesink pipeline with Lua handoff
+-- handler, after samples/gstplaystream.lua.
+scenarios[#scenarios + 1] = { 'gst', function()
+   local ok, Gst = pcall(lgi.require, 'Gst', '1.0')
+   if not ok then return 'Gst-1.0 not available' end
+
+   local count, rec = 20000, recorder()
+   local pipeline = Gst.parse_launch(
+      ('fakesrc num-buffers=%d sizetype=fixed sizemax=4096 ! '
+       .. 'fakesink name=sink signal-handoffs=true sync=false'):format(count))
+   local sink = pipeline:get_by_name('sink')
+   local received = 0
+   function sink:on_handoff(buffer)
+      received = received + buffer:get_size()
+      rec.mark()
+   end
+
+   local timer = GLib.Timer()
+   rec.start()
+   pipeline.state = 'PLAYING'
+   local message = pipeline.bus:timed_pop_filtered(
+      Gst.CLOCK_TIME_NONE, { 'EOS', 'ERROR' })
+   local elapsed = timer:elapsed()
+   pipeline.state = 'NULL'
+   assert(message.type.EOS, 'pipeline failed')
+   assert(received == count * 4096)
+   report('gst', count, 'buf', count, elapsed, rec.samples)
+end }
+
+local selected = {}
+for _, name in ipairs { ... } do selected[name] = true end
+for _, scenario in ipairs(scenarios) do
+   local name, run = scenario[1], scenario[2]
+   if not next(selected) or selected[name] then
+      local skipped = run()
+      if skipped then print(('%-8s skipped: %s'):format(name, skipped)) end
+      collectgarbage()
+   end
+end
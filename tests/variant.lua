@@ -233,6 +233,23 @@ function variant.serialize()
    local _ = v2:print(true)
 end
 
+function variant.lookup_sorted()
+   local V = GLib.Variant
+   local entries = {}
+   for i, key in ipairs { 'alpha', 'beta', 'delta', 'gamma', 'omega' } do
+      entries[i] = V('{sv}', { key, V('(si)', { key, i }) })
+   end
+   local source = V.new_array(GLib.VariantType('{sv}'), entries)
+   local v = V.new_from_view('a{sv}', GLib.Bytes.new(tostring(source.data)))
+   check(v:equal(source))
+   check(v:lookup_sorted('alpha')[2] == 1)
+   check(v:lookup_sorted('omega')[1] == 'omega')
+   check(v:lookup_sorted('delta').value[2] == 3)
+   check(v:lookup_sorted('epsilon') == nil)
+   check(v[4][1] == 'gamma')
+   check(not pcall(V.lookup_sorted, V('as', {}), 'key'))
+end
+
 -- Does pairs() on variant-dict (sa{sv}) honor the __pairs metamethod?
 if 42 == pairs(setmetatable({}, { __pairs = function() return 42 end })) then
     function variant.pairs_on_variant_returned_dict()
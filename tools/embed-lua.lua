@@ -0,0 +1,51 @@
+#! /usr/bin/env lua
+------------------------------------------------------------------------------
+--
+--  LGI tool for precompiling Lua modules into C header, which is
+--  embedded into the core module.
+--
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+--  Usage: embed-lua.lua output.h module.lua...
+--
+------------------------------------------------------------------------------
+
+local output = assert(arg[1], "usage: embed-lua.lua output.h module.lua...")
+
+-- Derives module name from the path of its source.
+local function module_name(path)
+   path = path:gsub('\\', '/')
+   local override = path:match('/override/([^/]+)%.lua$')
+   if override then return 'lgi.override.' .. override end
+   return 'lgi.' .. assert(path:match('([^/]+)%.lua$'), path)
+end
+
+-- Precompile all modules, sorted by name so that they can be bisected.
+local modules = {}
+for i = 2, #arg do
+   local chunk = assert(loadfile(arg[i]))
+   modules[#modules + 1] = { name = module_name(arg[i]),
+			     code = string.dump(chunk) }
+end
+table.sort(modules, function(a, b) return a.name < b.name end)
+
+local out = assert(io.open(output, 'w'))
+out:write('/* Generated by tools/embed-lua.lua, do not edit. */\n\n')
+for index, module in ipairs(modules) do
+   out:write(('/* %s */\nstatic const unsigned char embedded_%d[] = {'):format(
+		module.name, index))
+   for i = 1, #module.code do
+      if i % 16 == 1 then out:write('\n  ') end
+      out:write(module.code:byte(i), ',')
+   end
+   out:write('\n};\n\n')
+end
+
+out:write('static const EmbeddedModule embedded_modules[] = {\n')
+for index, module in ipairs(modules) do
+   out:write(('  { "%s", embedded_%d, sizeof (embedded_%d) },\n'):format(
+		module.name, index, index))
+end
+out:write('};\n')
+out:close()